@@ -1,25 +1,382 @@
 #include<stdio.h>
 #include<string.h>
-int main(){
+#include<stdint.h>
+#include<stdlib.h>
+#include<time.h>
+#ifdef __AVX2__
+#include<immintrin.h>
+#elif defined(__SSE2__)
+#include<emmintrin.h>
+#endif
 
-    char str[100];
-    printf("Enter string: ");
-    scanf("%s",str);
-    int i=0;
-    for(i=0;i<strlen(str)-2;i++){
-        if(str[i]!='a'){
-            printf("Invalid string\n");
+// Function to count how many of the first n bytes of s equal c, 32 (AVX2),
+// 16 (SSE2) or 8 (plain 64-bit words) bytes per compare
+static size_t runLength(const unsigned char *s, size_t n, unsigned char c){
+    size_t i=0;
+#ifdef __AVX2__
+    __m256i want=_mm256_set1_epi8((char)c);
+    for(;i+32<=n;i+=32){
+        __m256i x=_mm256_loadu_si256((const __m256i *)(s+i));
+        uint32_t diff=~(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(x,want));
+        if(diff) return i+__builtin_ctz(diff);
+    }
+#elif defined(__SSE2__)
+    __m128i want=_mm_set1_epi8((char)c);
+    for(;i+16<=n;i+=16){
+        __m128i x=_mm_loadu_si128((const __m128i *)(s+i));
+        uint32_t diff=~(uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(x,want))&0xFFFF;
+        if(diff) return i+__builtin_ctz(diff);
+    }
+#else
+    uint64_t want=0x0101010101010101ULL*c;
+    for(;i+8<=n;i+=8){
+        uint64_t x;
+        memcpy(&x,s+i,8);
+        if(x!=want) break;
+    }
+#endif
+    while(i<n && s[i]==c) i++;
+    return i;
+}
+
+// Run-length pattern: a sequence of runs, each of one character repeated
+// between min and max times (a*bb is "a*b{2}"). Runs may share a length
+// variable, so "a{n}b{n}" is a^n b^n. Characters of runs that can meet
+// (nothing but optional runs between them) must differ, so every string
+// splits into runs in exactly one way and each run can be measured greedily.
+#define MAX_RUNS 16
+#define NO_LIMIT ((size_t)-1)
+
+typedef struct {
+    int runs;
+    unsigned char c[MAX_RUNS];
+    size_t min[MAX_RUNS], max[MAX_RUNS];
+    int var[MAX_RUNS];      // length variable 'a'..'z' as 0..25, or -1
+} RunPattern;
+
+// Matching state, carried between pieces of one string
+typedef struct {
+    int item;               // run being measured
+    size_t len;             // its length so far
+    size_t value[26];       // lengths bound to variables
+    unsigned bound;         // bit v set once variable v has a length
+    int dead;
+} RunState;
+
+static size_t readCount(const char **s){
+    size_t n=0;
+    while(**s>='0' && **s<='9') n=n*10+(*(*s)++-'0');
+    return n;
+}
+
+// Function to parse a pattern such as "a*b{2}", "a+b{2,5}" or "a{n}b{n}".
+// Quantifiers: none (once), *, +, ?, {m}, {m,}, {m,n} and {v} for a length
+// variable v. Returns 0 and prints the reason if the pattern is not valid.
+static int parsePattern(const char *spec, RunPattern *p){
+    p->runs=0;
+    for(const char *s=spec;*s;){
+        if(p->runs==MAX_RUNS){
+            fprintf(stderr,"Pattern has more than %d runs\n",MAX_RUNS);
             return 0;
         }
-        
+        int r=p->runs++;
+        p->c[r]=(unsigned char)*s++;
+        p->min[r]=p->max[r]=1;
+        p->var[r]=-1;
+        if(*s=='*'){ p->min[r]=0; p->max[r]=NO_LIMIT; s++; }
+        else if(*s=='+'){ p->max[r]=NO_LIMIT; s++; }
+        else if(*s=='?'){ p->min[r]=0; s++; }
+        else if(*s=='{'){
+            s++;
+            if(*s>='a' && *s<='z' && s[1]=='}'){
+                p->var[r]=*s-'a';
+                p->min[r]=0;
+                p->max[r]=NO_LIMIT;
+                s++;
+            }
+            else{
+                if(*s<'0' || *s>'9'){
+                    fprintf(stderr,"Expected a count or variable after '{'\n");
+                    return 0;
+                }
+                p->min[r]=p->max[r]=readCount(&s);
+                if(*s==','){
+                    s++;
+                    p->max[r]=(*s=='}') ? NO_LIMIT : readCount(&s);
+                }
+            }
+            if(*s!='}' || p->max[r]<p->min[r]){
+                fprintf(stderr,"Bad repetition in pattern\n");
+                return 0;
+            }
+            s++;
+        }
+    }
+    for(int i=0;i<p->runs;i++){
+        for(int j=i+1;j<p->runs;j++){
+            if(p->c[i]==p->c[j]){
+                fprintf(stderr,"Runs %d and %d of the pattern can meet and use the same character\n",i+1,j+1);
+                return 0;
+            }
+            if(p->min[j]>0) break;
+        }
+    }
+    return 1;
+}
+
+static void runReset(RunState *st){
+    st->item=0;
+    st->len=0;
+    st->bound=0;
+    st->dead=0;
+}
+
+// Function to end the current run: check its length and move to the next
+static int runClose(const RunPattern *p, RunState *st){
+    int r=st->item;
+    if(st->len<p->min[r] || st->len>p->max[r]) return 0;
+    int v=p->var[r];
+    if(v>=0){
+        if((st->bound>>v)&1){
+            if(st->value[v]!=st->len) return 0;
+        }
+        else{
+            st->value[v]=st->len;
+            st->bound|=1u<<v;
+        }
+    }
+    st->item++;
+    st->len=0;
+    return 1;
+}
+
+// Function to advance the match over the next n bytes of the string. Each
+// run is measured with runLength, so the cost per byte is that of a vector
+// compare; a run that can no longer fit its limit ends the match early.
+static void runFeed(const RunPattern *p, RunState *st, const unsigned char *s, size_t n){
+    size_t i=0;
+    while(i<n && !st->dead){
+        if(st->item==p->runs){
+            st->dead=1;   // bytes after the last run
+            break;
+        }
+        size_t k=runLength(s+i,n-i,p->c[st->item]);
+        st->len+=k;
+        i+=k;
+        if(st->len>p->max[st->item]) st->dead=1;
+        else if(i<n && !runClose(p,st)) st->dead=1;
+    }
+}
+
+// Function to finish the string: the remaining runs must all be satisfied
+static int runAccepts(const RunPattern *p, RunState *st){
+    if(st->dead) return 0;
+    while(st->item<p->runs){
+        if(!runClose(p,st)) return 0;
+    }
+    return 1;
+}
+
+// Function to match a whole buffer one byte at a time with the same rules;
+// the baseline for the benchmark
+static int runMatchBytes(const RunPattern *p, const unsigned char *s, size_t n){
+    RunState st;
+    runReset(&st);
+    for(size_t i=0;i<n;i++){
+        while(st.item<p->runs && s[i]!=p->c[st.item]){
+            if(!runClose(p,&st)) return 0;
+        }
+        if(st.item==p->runs || ++st.len>p->max[st.item]) return 0;
+    }
+    return runAccepts(p,&st);
+}
+
+static int runMatch(const RunPattern *p, const unsigned char *s, size_t n){
+    RunState st;
+    runReset(&st);
+    runFeed(p,&st,s,n);
+    return runAccepts(p,&st);
+}
+
+// Function to time the run-length engine against the byte loop on a^n b^n
+// inputs from 1 KB up to maxMB, each measured over at least 256 MB of work
+static void benchmarkRuns(size_t maxMB){
+    RunPattern p;
+    parsePattern("a{n}b{n}",&p);
+    size_t maxSize=maxMB<<20;
+    unsigned char *buf=malloc(maxSize ? maxSize : 1);
+    if(buf==NULL){
+        fprintf(stderr,"Cannot allocate %zu MB\n",maxMB);
+        return;
+    }
+    printf("Pattern a{n}b{n}\n");
+    printf("%10s %14s %14s\n","Input","Byte loop","Run engine");
+    for(size_t size=1024;size<=maxSize;size*=32){
+        memset(buf,'a',size/2);
+        memset(buf+size/2,'b',size-size/2);
+        size_t reps=((size_t)256<<20)/size;
+        if(reps==0) reps=1;
+        double rate[2];
+        int ok[2];
+        for(int k=0;k<2;k++){
+            clock_t t0=clock();
+            ok[k]=1;
+            for(size_t r=0;r<reps;r++){
+                ok[k]&=k==0 ? runMatchBytes(&p,buf,size) : runMatch(&p,buf,size);
+            }
+            double secs=(double)(clock()-t0)/CLOCKS_PER_SEC;
+            rate[k]=size/1e6*reps/(secs>0 ? secs : 1e-9);
+        }
+        char label[32];
+        if(size>=(1<<20)) sprintf(label,"%zu MB",size>>20);
+        else sprintf(label,"%zu KB",size>>10);
+        printf("%10s %9.0f MB/s %9.0f MB/s%s\n",label,rate[0],rate[1],ok[0] && ok[1] ? "" : "  (no match!)");
+    }
+    free(buf);
+}
+
+// Batch results are collected here and written 1 MB at a time
+static char out[(1<<20)+32];
+static size_t used=0;
+
+static void report(int ok){
+    const char *msg=ok ? "Valid string\n" : "Invalid string\n";
+    size_t m=strlen(msg);
+    memcpy(out+used,msg,m);
+    used+=m;
+    if(used>=(1<<20)){
+        fwrite(out,1,used,stdout);
+        used=0;
+    }
+}
+
+// Function to check newline-separated strings from a file (or stdin for
+// "-"). Input is read in 1 MB blocks; a string cut by a block boundary keeps
+// its state, so lines of any length work. CRLF is treated like LF.
+static int runBatch(const RunPattern *pat, const char *path, int countOnly){
+    static unsigned char buf[1<<20];
+    FILE *in=stdin;
+    if(strcmp(path,"-")!=0){
+        in=fopen(path,"rb");
+        if(in==NULL){
+            fprintf(stderr,"Input file not found: %s\n",path);
+            return 1;
+        }
+    }
+
+    unsigned long long total=0,valid=0,bytes=0;
+    size_t n;
+    RunState st;
+    int inString=0,pendingCR=0;
+    runReset(&st);
+    clock_t start=clock();
+
+    while((n=fread(buf,1,sizeof(buf),in))>0){
+        const unsigned char *p=buf,*end=buf+n,*nl;
+        bytes+=n;
+        if(pendingCR){
+            pendingCR=0;
+            if(*p!='\n') runFeed(pat,&st,(const unsigned char *)"\r",1);
+        }
+        while(1){
+            nl=memchr(p,'\n',end-p);
+            size_t len=(nl ? nl : end)-p;
+            if(len>0 && p[len-1]=='\r'){
+                len--;
+                if(nl==NULL) pendingCR=1;
+            }
+            runFeed(pat,&st,p,len);
+            if(nl==NULL){
+                if(len>0 || pendingCR) inString=1;
+                break;
+            }
+
+            int ok=runAccepts(pat,&st);
+            total++;
+            valid+=ok;
+            if(!countOnly) report(ok);
+            runReset(&st);
+            inString=0;
+            p=nl+1;
+        }
+    }
+    if(pendingCR) runFeed(pat,&st,(const unsigned char *)"\r",1);
+    if(inString){
+        int ok=runAccepts(pat,&st);
+        total++;
+        valid+=ok;
+        if(!countOnly) report(ok);
+    }
+    double secs=(double)(clock()-start)/CLOCKS_PER_SEC;
+    fwrite(out,1,used,stdout);
+    if(in!=stdin) fclose(in);
+
+    if(countOnly){
+        printf("Strings : %llu\nValid   : %llu\nInvalid : %llu\n",total,valid,total-valid);
+    }
+    fprintf(stderr,"%llu strings, %.1f MB in %.3f s\n",total,bytes/1e6,secs);
+    return 0;
+}
+
+int main(int argc, char *argv[]){
+
+    // Without --pattern the program recognizes a*bb, as it always has
+    const char *spec="a*b{2}";
+    const char *path="-";
+    int batch=0,bench=0,countOnly=0;
+    size_t benchMB=1024;
+    for(int i=1;i<argc;i++){
+        if(strcmp(argv[i],"--batch")==0) batch=1;
+        else if(strcmp(argv[i],"--count")==0) countOnly=1;
+        else if(strcmp(argv[i],"--pattern")==0 && i+1<argc) spec=argv[++i];
+        else if(strcmp(argv[i],"--bench")==0){
+            bench=1;
+            if(i+1<argc && argv[i+1][0]>='0' && argv[i+1][0]<='9') benchMB=strtoul(argv[++i],NULL,10);
+        }
+        else if(strncmp(argv[i],"--",2)!=0) path=argv[i];
+        else{
+            fprintf(stderr,"Usage: %s [--pattern P]                    (interactive)\n",argv[0]);
+            fprintf(stderr,"       %s --batch [input|-] [--count] [--pattern P]\n",argv[0]);
+            fprintf(stderr,"       %s --bench [max-MB]\n",argv[0]);
+            return 1;
+        }
+    }
+    if(bench){
+        benchmarkRuns(benchMB);
+        return 0;
+    }
+    RunPattern pat;
+    if(!parsePattern(spec,&pat)) return 1;
+    if(batch) return runBatch(&pat,path,countOnly);
+
+    // Read one whitespace-separated word, like scanf("%s"), but in chunks so
+    // that it can be any length
+    static char chunk[1<<16];
+    const char *space=" \t\n\r\f\v";
+    int started=0,done=0;
+    RunState st;
+    runReset(&st);
+    printf("Enter string: ");
+    fflush(stdout);
+    while(!done && fgets(chunk,sizeof(chunk),stdin)){
+        size_t len=strlen(chunk);
+        size_t i=0;
+        if(!started){
+            i=strspn(chunk,space);
+            if(i==len) continue;
+            started=1;
+        }
+        size_t word=strcspn(chunk+i,space);
+        runFeed(&pat,&st,(const unsigned char *)chunk+i,word);
+        done=i+word<len;
     }
 
-    if(str[i]=='b' && str[i+1]=='b'){
+    if(started && runAccepts(&pat,&st)){
         printf("Valid string\n");
     }
     else{
         printf("Invalid string\n");
     }
-    return 0;  
+    return 0;
 
-}
\ No newline at end of file
+}
@@ -0,0 +1,165 @@
+#ifndef GLUSHKOV_NFA_H
+#define GLUSHKOV_NFA_H
+
+#include <cstdint>
+#include <string>
+#include "regex_dfa.h"
+
+// Bit-parallel simulation of the Glushkov automaton of a regex. Every byte
+// set in the pattern (after bounded repeats are expanded) is one position,
+// position 0 is the start, and the set of active positions is one 64-bit
+// word. A step is D' = follow(D) & mask[byte]: follow(D) is the union of the
+// positions that may come after those in D, read from one table per 8
+// positions. A pattern whose positions simply follow one another needs no
+// table and steps as Shift-And, D' = (D << 1) & mask[byte]. There is no
+// determinization and no cache, so the object is immutable after
+// construction. Matching is anchored at both ends, like LazyDFA.
+class BitNFA {
+public:
+    static const int MAX_POSITIONS = 64;   // including the start position
+
+    uint64_t init = 1;
+
+    explicit BitNFA(const std::string& pattern) {
+        std::unique_ptr<RegexNode> root = RegexParser(pattern).parse();
+        for (int b = 0; b < 256; b++) byteMask[b] = 0;
+        for (int p = 0; p < MAX_POSITIONS; p++) follow[p] = 0;
+
+        Info all = walk(*root);
+        if (overflow) return;
+        follow[0] = all.first;
+        final = all.last | (all.nullable ? 1 : 0);
+
+        shift = true;
+        for (int p = 0; p < count; p++) {
+            uint64_t next = p + 1 < count ? (uint64_t)1 << (p + 1) : 0;
+            if (follow[p] != next) shift = false;
+        }
+
+        chunks = (count + 7) / 8;
+        table.assign((size_t)chunks * 256, 0);
+        for (int k = 0; k < chunks; k++) {
+            for (int v = 1; v < 256; v++) {
+                int low = v & -v, bit = 0;
+                while ((1 << bit) != low) bit++;
+                uint64_t f = 8 * k + bit < count ? follow[8 * k + bit] : 0;
+                table[(size_t)k * 256 + v] = table[(size_t)k * 256 + (v & (v - 1))] | f;
+            }
+        }
+    }
+
+    // False if the pattern needs more than MAX_POSITIONS positions
+    bool ok() const { return !overflow; }
+    int positions() const { return count; }
+    bool shiftAnd() const { return shift; }
+
+    uint64_t step(uint64_t D, const unsigned char* s, size_t n) const {
+        if (shift) {
+            for (size_t i = 0; i < n && D; i++) {
+                D = (D << 1) & byteMask[s[i]];
+            }
+            return D;
+        }
+        const uint64_t* T = table.data();
+        for (size_t i = 0; i < n && D; i++) {
+            uint64_t f = 0;
+            for (int k = 0; k < chunks; k++) {
+                f |= T[k * 256 + ((D >> (8 * k)) & 255)];
+            }
+            D = f & byteMask[s[i]];
+        }
+        return D;
+    }
+
+    bool accepting(uint64_t D) const { return (D & final) != 0; }
+
+private:
+    struct Info {
+        bool nullable;
+        uint64_t first, last;
+    };
+
+    uint64_t byteMask[256];
+    uint64_t follow[MAX_POSITIONS];
+    std::vector<uint64_t> table;   // chunks x 256 follow unions
+    uint64_t final = 0;
+    int count = 1;
+    int chunks = 0;
+    bool shift = false;
+    bool overflow = false;
+
+    void link(uint64_t last, uint64_t first) {
+        for (int p = 0; p < count; p++) {
+            if ((last >> p) & 1) follow[p] |= first;
+        }
+    }
+
+    Info concat(Info a, Info b) {
+        link(a.last, b.first);
+        return {a.nullable && b.nullable,
+                a.nullable ? a.first | b.first : a.first,
+                b.nullable ? a.last | b.last : b.last};
+    }
+
+    // Function to number the positions of node (each walk of a repeated
+    // subtree makes fresh positions) and return its nullable/first/last sets
+    Info walk(const RegexNode& node) {
+        Info none = {true, 0, 0};
+        if (overflow) return none;
+        switch (node.type) {
+        case RegexNode::EMPTY:
+            return none;
+        case RegexNode::BYTES: {
+            if (count == MAX_POSITIONS) {
+                overflow = true;
+                return none;
+            }
+            uint64_t bit = (uint64_t)1 << count++;
+            for (int b = 0; b < 256; b++) {
+                if (node.set[b]) byteMask[b] |= bit;
+            }
+            return {false, bit, bit};
+        }
+        case RegexNode::CONCAT: {
+            Info acc = none;
+            for (const auto& kid : node.kids) acc = concat(acc, walk(*kid));
+            return acc;
+        }
+        case RegexNode::ALT: {
+            Info acc = {false, 0, 0};
+            for (const auto& kid : node.kids) {
+                Info k = walk(*kid);
+                acc = {acc.nullable || k.nullable, acc.first | k.first, acc.last | k.last};
+            }
+            return acc;
+        }
+        case RegexNode::REPEAT: {
+            const RegexNode& kid = *node.kids[0];
+            Info acc = none;
+            for (int i = 0; i < node.min && !overflow; i++) acc = concat(acc, walk(kid));
+            if (node.max < 0) {
+                Info k = walk(kid);
+                link(k.last, k.first);
+                return concat(acc, {true, k.first, k.last});
+            }
+            // x{0,n} is n optional copies in a row
+            for (int i = node.min; i < node.max && !overflow; i++) {
+                Info k = walk(kid);
+                acc = concat(acc, {true, k.first, k.last});
+            }
+            return acc;
+        }
+        }
+        return none;
+    }
+};
+
+inline uint64_t stepDFA(const BitNFA& nfa, uint64_t current, const unsigned char* s, size_t n) {
+    return nfa.step(current, s, n);
+}
+
+inline bool isAccepting(const BitNFA& nfa, uint64_t state) {
+    return nfa.accepting(state);
+}
+
+#endif
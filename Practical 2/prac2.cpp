@@ -1,8 +1,2631 @@
 #include <iostream>
 #include <string>
+#include <string_view>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <numeric>
+#include <map>
+#include <deque>
+#include <unordered_map>
+#include <algorithm>
+#include <cstdint>
+#ifdef __AVX2__
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#include <io.h>
+#include <fcntl.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+#include "static_dfa.h"
+#include "regex_dfa.h"
+#include "glushkov_nfa.h"
 using namespace std;
 
+// Test case 3: identifier automaton (a letter followed by letters or digits)
+constexpr char TC3_INPUT[36] = {'a', 'b', 'c', 'd', 'e', 'f', 'g', 'h', 'i', 'j', 'k', 'l', 'm',
+                                'n', 'o', 'p', 'q', 'r', 's', 't', 'u', 'v', 'w', 'x', 'y', 'z',
+                                '0', '1', '2', '3', '4', '5', '6', '7', '8', '9'};
+constexpr int TC3_STATES = 3;
+constexpr int TC3_INIT = 1;
+constexpr int TC3_ACCEPT[1] = {2};
+constexpr int TC3_TT[4][36] = {
+    {2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,3,3,3,3,3,3,3,3,3,3},
+    {2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2},
+    {3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3},
+    {3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3}
+};
+
+// Test case 3 compiled at build time, with its 37 columns merged into byte classes
+constexpr auto TC3_FULL = makeStaticSpec<TC3_STATES>(TC3_INPUT, TC3_TT, TC3_INIT, TC3_ACCEPT);
+constexpr auto TC3_SPEC = compressByteClasses<countByteClasses(TC3_FULL)>(TC3_FULL);
+using IdentifierDFA = StaticDFA<TC3_SPEC>;
+
+int cellWidth(int rows) {
+    if (rows <= 256) return 1;
+    if (rows <= 65536) return 2;
+    return 4;
+}
+
+// Transition table stored with the narrowest cell type that can hold every
+// state number, so small automata fit in a few cache lines and large ones
+// (100k+ states) still work. get/set are for building; hot loops go through
+// withCells and see the raw cell array.
+class StateTable {
+public:
+    void assign(size_t cells, int rows, uint32_t fill) {
+        w = cellWidth(rows);
+        n = cells;
+        c8.clear();
+        c16.clear();
+        c32.clear();
+        if (w == 1) c8.assign(cells, fill);
+        else if (w == 2) c16.assign(cells, fill);
+        else c32.assign(cells, fill);
+    }
+
+    uint32_t get(size_t i) const {
+        return w == 1 ? c8[i] : w == 2 ? c16[i] : c32[i];
+    }
+
+    void set(size_t i, uint32_t v) {
+        if (w == 1) c8[i] = v;
+        else if (w == 2) c16[i] = v;
+        else c32[i] = v;
+    }
+
+    int width() const { return w; }
+    size_t size() const { return n; }
+    size_t bytes() const { return n * w; }
+
+    const void* data() const {
+        return w == 1 ? (const void*)c8.data() : w == 2 ? (const void*)c16.data() : (const void*)c32.data();
+    }
+
+private:
+    int w = 1;
+    size_t n = 0;
+    vector<uint8_t> c8;
+    vector<uint16_t> c16;
+    vector<uint32_t> c32;
+};
+
+// Function to call f with the table cast to its cell type, so hot loops are
+// compiled once per width and dispatch only once per call
+template <typename F>
+auto withCells(const StateTable& table, F f) {
+    switch (table.width()) {
+    case 1: return f((const uint8_t*)table.data());
+    case 2: return f((const uint16_t*)table.data());
+    default: return f((const uint32_t*)table.data());
+    }
+}
+
+// Bytes a state loops on, kept when they form a few ranges and make up at
+// least half of the bytes that keep the state alive, so a run of them can be
+// skipped with a vector range check instead of one table step per byte.
+// LOOP_ALL marks absorbing states (the dead state), where scanning can stop.
+const int MAX_LOOP_RANGES = 4;
+enum LoopKind : uint8_t { LOOP_NONE, LOOP_RANGES, LOOP_ALL };
+
+struct SelfLoop {
+    LoopKind kind;
+    uint8_t ranges;
+    uint8_t lo[MAX_LOOP_RANGES], hi[MAX_LOOP_RANGES];
+};
+
+// Compiled automaton: the alphabet is folded into a 256-entry byte -> column
+// map, so each input character costs one load plus one table lookup no
+// matter how many symbols the user entered.
+struct CompiledDFA {
+    int no_state;            // user states are 0..no_state-1, dead state is no_state
+    int no_col;              // user symbols plus one reject column, or byte classes once compressed
+    int init;                // 0-based initial state
+    uint16_t col[256];       // byte -> column, bytes outside the alphabet -> reject column
+    StateTable table;        // (no_state + 1) rows of no_col 0-based targets
+    vector<uint64_t> accept; // accepting states as a bitset
+    string alphabet;
+    vector<SelfLoop> loops;  // per state, filled by findSelfLoops; empty = plain stepping
+};
+
+bool isAccepting(const CompiledDFA& dfa, int state) {
+    return (dfa.accept[state / 64] >> (state % 64)) & 1;
+}
+
+void setAccepting(vector<uint64_t>& accept, int state) {
+    accept[state / 64] |= (uint64_t)1 << (state % 64);
+}
+
+// Function to compile the entered automaton (1-based states, TT rows of
+// length stride) into the byte-indexed form
+CompiledDFA compileDFA(const char input[], int no_input, int no_state, int init,
+                       const int accept[], int no_accept, const int* TT, int stride) {
+    CompiledDFA dfa;
+    dfa.no_state = no_state;
+    dfa.no_col = no_input + 1;
+    dfa.init = init - 1;
+    dfa.alphabet.assign(input, input + no_input);
+
+    int reject = no_input;
+    for (int b = 0; b < 256; b++) {
+        dfa.col[b] = reject;
+    }
+    // Later duplicates of a symbol never matched in the linear scan, so keep the first
+    for (int j = no_input - 1; j >= 0; j--) {
+        dfa.col[(unsigned char)input[j]] = j;
+    }
+
+    int dead = no_state;
+    dfa.table.assign((size_t)(no_state + 1) * dfa.no_col, no_state + 1, dead);
+    for (int i = 0; i < no_state; i++) {
+        for (int j = 0; j < no_input; j++) {
+            dfa.table.set((size_t)i * dfa.no_col + j, TT[(size_t)i * stride + j] - 1);
+        }
+    }
+
+    dfa.accept.assign(no_state / 64 + 1, 0);
+    for (int i = 0; i < no_accept; i++) {
+        setAccepting(dfa.accept, accept[i] - 1);
+    }
+    return dfa;
+}
+
+// Function to minimise the automaton in place with Hopcroft's partition
+// refinement. States unreachable from the initial state are dropped first,
+// then equivalent states are merged. The dead state stays the last row.
+void minimizeDFA(CompiledDFA& dfa) {
+    const int k = dfa.no_col;
+    const int total = dfa.no_state + 1;
+
+    // Reachable states in BFS order (the reject column always reaches the dead state)
+    vector<int> newId(total, -1), order;
+    newId[dfa.init] = 0;
+    order.push_back(dfa.init);
+    for (size_t h = 0; h < order.size(); h++) {
+        for (int c = 0; c < k; c++) {
+            int t = dfa.table.get((size_t)order[h] * k + c);
+            if (newId[t] < 0) {
+                newId[t] = order.size();
+                order.push_back(t);
+            }
+        }
+    }
+    const int n = order.size();
+    vector<int> T((size_t)n * k);
+    for (int i = 0; i < n; i++) {
+        for (int c = 0; c < k; c++) {
+            T[(size_t)i * k + c] = newId[dfa.table.get((size_t)order[i] * k + c)];
+        }
+    }
+
+    // Inverse transitions: sources of (target, column) stored contiguously
+    vector<int> invStart((size_t)n * k + 1, 0), inv((size_t)n * k);
+    for (size_t i = 0; i < T.size(); i++) {
+        invStart[(size_t)T[i] * k + i % k + 1]++;
+    }
+    for (size_t i = 1; i < invStart.size(); i++) {
+        invStart[i] += invStart[i - 1];
+    }
+    vector<int> fill(invStart.begin(), invStart.end() - 1);
+    for (size_t i = 0; i < T.size(); i++) {
+        inv[fill[(size_t)T[i] * k + i % k]++] = i / k;
+    }
+
+    // Refinable partition: each block is a range of elems, marked states at its front
+    vector<int> elems, loc(n), blk(n), first, past, marked;
+    for (int pass = 0; pass < 2; pass++) {
+        int start = elems.size();
+        for (int i = 0; i < n; i++) {
+            if (isAccepting(dfa, order[i]) == (pass == 0)) {
+                loc[i] = elems.size();
+                blk[i] = first.size();
+                elems.push_back(i);
+            }
+        }
+        if ((int)elems.size() > start) {
+            first.push_back(start);
+            past.push_back(elems.size());
+            marked.push_back(0);
+        }
+    }
+
+    vector<pair<int, int>> work;
+    if (first.size() == 2) {
+        int smaller = (past[0] - first[0] <= past[1] - first[1]) ? 0 : 1;
+        for (int c = 0; c < k; c++) {
+            work.push_back({smaller, c});
+        }
+    }
+
+    vector<int> splitter, touched;
+    while (!work.empty()) {
+        int B = work.back().first, c = work.back().second;
+        work.pop_back();
+
+        splitter.assign(elems.begin() + first[B], elems.begin() + past[B]);
+        for (int s : splitter) {
+            for (int i = invStart[(size_t)s * k + c]; i < invStart[(size_t)s * k + c + 1]; i++) {
+                int p = inv[i], b = blk[p];
+                int j = first[b] + marked[b];
+                if (loc[p] < j) continue;  // already marked
+                swap(elems[loc[p]], elems[j]);
+                loc[elems[loc[p]]] = loc[p];
+                loc[p] = j;
+                if (marked[b]++ == 0) touched.push_back(b);
+            }
+        }
+
+        for (int b : touched) {
+            int m = marked[b];
+            marked[b] = 0;
+            if (m == past[b] - first[b]) continue;
+
+            // The smaller half becomes the new block
+            int nb = first.size();
+            if (m <= past[b] - first[b] - m) {
+                first.push_back(first[b]);
+                past.push_back(first[b] + m);
+                first[b] += m;
+            } else {
+                first.push_back(first[b] + m);
+                past.push_back(past[b]);
+                past[b] = first[b] + m;
+            }
+            marked.push_back(0);
+            for (int i = first[nb]; i < past[nb]; i++) {
+                blk[elems[i]] = nb;
+            }
+            // Queueing the smaller half is enough: if (b, d) is still
+            // pending, it now stands for the other half, so both are covered
+            for (int d = 0; d < k; d++) {
+                work.push_back({nb, d});
+            }
+        }
+        touched.clear();
+    }
+
+    // Number blocks in BFS order with the dead state's block last
+    int blocks = first.size();
+    int deadBlock = blk[newId[dfa.no_state]];
+    vector<int> blockId(blocks, -1);
+    int next = 0;
+    for (int i = 0; i < n; i++) {
+        if (blockId[blk[i]] < 0 && blk[i] != deadBlock) {
+            blockId[blk[i]] = next++;
+        }
+    }
+    blockId[deadBlock] = next;
+
+    StateTable table;
+    table.assign((size_t)blocks * k, blocks, 0);
+    vector<uint64_t> accept(blocks / 64 + 1, 0);
+    for (int b = 0; b < blocks; b++) {
+        int rep = elems[first[b]];
+        for (int c = 0; c < k; c++) {
+            table.set((size_t)blockId[b] * k + c, blockId[blk[T[(size_t)rep * k + c]]]);
+        }
+        if (isAccepting(dfa, order[rep])) setAccepting(accept, blockId[b]);
+    }
+
+    dfa.no_state = blocks - 1;
+    dfa.init = blockId[blk[0]];
+    dfa.table = move(table);
+    dfa.accept.swap(accept);
+    dfa.loops.clear();
+}
+
+// Function to merge columns that lead to the same state from every state
+// into one byte class. Only columns some byte maps to are kept, numbered in
+// byte order, and col[] is rewritten to the class ids, so every form built
+// from the compiled automaton (file, lane table, generated code) shares it.
+void compressColumns(CompiledDFA& dfa) {
+    const int k = dfa.no_col;
+    const int rows = dfa.no_state + 1;
+
+    map<vector<uint32_t>, int> classOf;
+    vector<int> classId(k, -1), rep;
+    vector<uint32_t> column(rows);
+    for (int b = 0; b < 256; b++) {
+        int c = dfa.col[b];
+        if (classId[c] >= 0) continue;
+        for (int r = 0; r < rows; r++) {
+            column[r] = dfa.table.get((size_t)r * k + c);
+        }
+        auto it = classOf.emplace(column, (int)rep.size());
+        if (it.second) rep.push_back(c);
+        classId[c] = it.first->second;
+    }
+
+    const int m = rep.size();
+    StateTable table;
+    table.assign((size_t)rows * m, rows, 0);
+    for (int r = 0; r < rows; r++) {
+        for (int j = 0; j < m; j++) {
+            table.set((size_t)r * m + j, dfa.table.get((size_t)r * k + rep[j]));
+        }
+    }
+    for (int b = 0; b < 256; b++) {
+        dfa.col[b] = classId[dfa.col[b]];
+    }
+    dfa.no_col = m;
+    dfa.table = move(table);
+    dfa.loops.clear();
+}
+
+// Function to store the byte set in[] as ranges in L. Returns the number of
+// ranges the set needs; only the first MAX_LOOP_RANGES of them are stored.
+int setRanges(const bool in[256], SelfLoop& L) {
+    int ranges = 0;
+    for (int b = 0; b < 256; b++) {
+        if (!in[b]) continue;
+        bool extends = b > 0 && in[b - 1];
+        if (!extends) ranges++;
+        if (ranges > MAX_LOOP_RANGES) continue;
+        if (!extends) L.lo[ranges - 1] = b;
+        L.hi[ranges - 1] = b;
+    }
+    L.ranges = min(ranges, MAX_LOOP_RANGES);
+    return ranges;
+}
+
+// Function to record, for every state, the bytes it loops on (see SelfLoop).
+// Run last, since minimizeDFA and compressColumns renumber and drop them.
+void findSelfLoops(CompiledDFA& dfa) {
+    const int rows = dfa.no_state + 1;
+    dfa.loops.assign(rows, SelfLoop{});
+    bool in[256];
+    for (int st = 0; st < rows; st++) {
+        SelfLoop& L = dfa.loops[st];
+        int looping = 0, live = 0;
+        for (int b = 0; b < 256; b++) {
+            uint32_t t = dfa.table.get((size_t)st * dfa.no_col + dfa.col[b]);
+            live += t != (uint32_t)dfa.no_state;
+            in[b] = t == (uint32_t)st;
+            looping += in[b];
+        }
+        int ranges = setRanges(in, L);
+        if (looping == 256) {
+            L.kind = LOOP_ALL;
+        } else if (looping > 0 && ranges <= MAX_LOOP_RANGES && 2 * looping >= live) {
+            L.kind = LOOP_RANGES;
+        }
+    }
+}
+
+// Function to minimise the automaton, merge its byte classes and report the
+// state and column counts
+void minimizeAndReport(CompiledDFA& dfa, ostream& out) {
+    int before = dfa.no_state + 1;
+    minimizeDFA(dfa);
+    out << "Minimized DFA: " << before << " -> " << dfa.no_state + 1
+        << " states (dead state included)\n";
+    int columns = dfa.no_col;
+    compressColumns(dfa);
+    out << "Byte classes: " << columns << " -> " << dfa.no_col
+        << " columns (reject column included)\n";
+    findSelfLoops(dfa);
+    out << "Transition table: " << dfa.no_state + 1 << " x " << dfa.no_col << " cells of "
+        << dfa.table.width() << " byte(s) = " << dfa.table.bytes() << " bytes\n";
+}
+
+template <typename Cell>
+int stepTable(const Cell* T, const uint16_t* col, int stride, int current,
+              const unsigned char* s, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        current = T[(size_t)current * stride + col[s[i]]];
+    }
+    return current;
+}
+
+// Function to count the leading bytes of s that a state loops on, 32 (or 16)
+// bytes per vector step: byte b is in [lo, hi] iff (b - lo) <= (hi - lo) unsigned
+size_t loopRun(const SelfLoop& L, const unsigned char* s, size_t n) {
+    size_t i = 0;
+#ifdef __AVX2__
+    const __m256i zero = _mm256_setzero_si256();
+    for (; i + 32 <= n; i += 32) {
+        __m256i x = _mm256_loadu_si256((const __m256i*)(s + i));
+        __m256i in = zero;
+        for (int r = 0; r < L.ranges; r++) {
+            __m256i d = _mm256_sub_epi8(x, _mm256_set1_epi8((char)L.lo[r]));
+            __m256i over = _mm256_subs_epu8(d, _mm256_set1_epi8((char)(L.hi[r] - L.lo[r])));
+            in = _mm256_or_si256(in, _mm256_cmpeq_epi8(over, zero));
+        }
+        uint32_t out = ~(uint32_t)_mm256_movemask_epi8(in);
+        if (out) return i + __builtin_ctz(out);
+    }
+#elif defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 16 <= n; i += 16) {
+        __m128i x = _mm_loadu_si128((const __m128i*)(s + i));
+        __m128i in = zero;
+        for (int r = 0; r < L.ranges; r++) {
+            __m128i d = _mm_sub_epi8(x, _mm_set1_epi8((char)L.lo[r]));
+            __m128i over = _mm_subs_epu8(d, _mm_set1_epi8((char)(L.hi[r] - L.lo[r])));
+            in = _mm_or_si128(in, _mm_cmpeq_epi8(over, zero));
+        }
+        uint32_t out = ~(uint32_t)_mm_movemask_epi8(in) & 0xFFFF;
+        if (out) return i + __builtin_ctz(out);
+    }
+#endif
+    for (; i < n; i++) {
+        int r = 0;
+        while (r < L.ranges && (uint8_t)(s[i] - L.lo[r]) > L.hi[r] - L.lo[r]) r++;
+        if (r == L.ranges) break;
+    }
+    return i;
+}
+
+// Same as stepTable, but runs of self-loop bytes are skipped with loopRun and
+// an absorbing state ends the scan, since no later byte can change it
+template <typename Cell>
+int stepSkipping(const Cell* T, const uint16_t* col, int stride, const SelfLoop* loops,
+                 int current, const unsigned char* s, size_t n) {
+    size_t i = 0;
+    while (i < n) {
+        const SelfLoop& L = loops[current];
+        if (L.kind == LOOP_ALL) break;
+        if (L.kind == LOOP_RANGES) {
+            i += loopRun(L, s + i, n - i);
+            if (i == n) break;
+        }
+        current = T[(size_t)current * stride + col[s[i++]]];
+    }
+    return current;
+}
+
+// Function to advance the automaton from a given 0-based state over a buffer
+int stepDFA(const CompiledDFA& dfa, int current, const unsigned char* s, size_t n) {
+    return withCells(dfa.table, [&](auto T) {
+        if (dfa.loops.empty()) return stepTable(T, dfa.col, dfa.no_col, current, s, n);
+        return stepSkipping(T, dfa.col, dfa.no_col, dfa.loops.data(), current, s, n);
+    });
+}
+
+// Function to run the automaton one table step per byte, ignoring self-loops
+int runPlain(const CompiledDFA& dfa, const unsigned char* s, size_t n) {
+    return withCells(dfa.table, [&](auto T) {
+        return stepTable(T, dfa.col, dfa.no_col, dfa.init, s, n);
+    });
+}
+
+// Function to run the automaton over a buffer and return the final 0-based state
+int runDFA(const CompiledDFA& dfa, const unsigned char* s, size_t n) {
+    return stepDFA(dfa, dfa.init, s, n);
+}
+
+bool acceptsDFA(const CompiledDFA& dfa, const string& str) {
+    return isAccepting(dfa, runDFA(dfa, (const unsigned char*)str.data(), str.length()));
+}
+
+// Function to run the automaton the old way (linear scan of the alphabet per
+// character), kept as the baseline for the throughput report
+int runLinearScan(const CompiledDFA& dfa, const unsigned char* s, size_t n) {
+    return withCells(dfa.table, [&](auto T) {
+        const int stride = dfa.no_col;
+        const int no_input = dfa.alphabet.length();
+        int current = dfa.init;
+
+        for (size_t i = 0; i < n; i++) {
+            bool found = false;
+            for (int j = 0; j < no_input; j++) {
+                if (s[i] == (unsigned char)dfa.alphabet[j]) {
+                    current = T[(size_t)current * stride + dfa.col[s[i]]];  // column of symbol j
+                    found = true;
+                    break;
+                }
+            }
+            if (!found) {
+                return dfa.no_state;
+            }
+        }
+        return current;
+    });
+}
+
+// Function to time both simulators over random text drawn from the alphabet
+void benchmarkDFA(const CompiledDFA& dfa) {
+    const size_t size = 64 << 20;
+    vector<unsigned char> buf(size);
+    mt19937 rng(12345);
+    for (size_t i = 0; i < size; i++) {
+        buf[i] = dfa.alphabet[rng() % dfa.alphabet.length()];
+    }
+
+    auto time = [&](int (*run)(const CompiledDFA&, const unsigned char*, size_t), int& state) {
+        auto start = chrono::steady_clock::now();
+        state = run(dfa, buf.data(), size);
+        chrono::duration<double> secs = chrono::steady_clock::now() - start;
+        return (size / 1e6) / secs.count();
+    };
+
+    int tableState, skipState, scanState;
+    double tableRate = time(runPlain, tableState);
+    double skipRate = time(runDFA, skipState);
+    double scanRate = time(runLinearScan, scanState);
+
+    cout << "Alphabet size    : " << dfa.alphabet.length() << " symbols\n";
+    cout << "Input size       : " << (size >> 20) << " MB\n";
+    cout << "Byte-table lookup: " << tableRate << " MB/s\n";
+    cout << "Self-loop skips  : " << skipRate << " MB/s\n";
+    cout << "Linear scan      : " << scanRate << " MB/s\n";
+    if (tableState != scanState || skipState != scanState) {
+        cout << "Warning: simulators disagree on final state\n";
+    }
+}
+
+// Compiled DFA file: a fixed header followed by 64-byte aligned sections for
+// the byte -> column map, the accepting bitset, the state table (cells as
+// narrow as the state count allows) and the alphabet. Sections are used in
+// place from the mapped file, so loading costs no parsing or copying and
+// processes mapping the same file share one copy of the table.
+const char DFA_MAGIC[4] = {'D', 'F', 'A', 'B'};
+const uint32_t DFA_VERSION = 1;
+const uint32_t DFA_BYTE_ORDER = 0x01020304;
+
+struct DFAFileHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t byteOrder;      // DFA_BYTE_ORDER as written by the exporter
+    uint32_t rows;           // states including the dead state (last row)
+    uint32_t no_col;
+    uint32_t init;
+    uint32_t width;          // bytes per table cell: 1, 2 or 4
+    uint32_t alphabetLen;
+    uint64_t colOffset;      // uint16_t[256]
+    uint64_t acceptOffset;   // uint64_t[(rows + 63) / 64]
+    uint64_t tableOffset;    // rows * no_col cells of width bytes
+    uint64_t alphabetOffset;
+    uint64_t fileSize;
+};
+
+// Read-only view of a mapped DFA file
+struct MappedDFA {
+    int no_state;            // dead state index, as in CompiledDFA
+    int no_col;
+    int init;
+    int width;
+    const uint16_t* col;
+    const uint64_t* accept;
+    const void* table;
+    string alphabet;
+    void* base = NULL;
+    size_t size = 0;
+};
+
+// Function to write the compiled automaton to a versioned binary file
+bool exportDFA(const CompiledDFA& dfa, const char* path) {
+    auto align = [](uint64_t off) { return (off + 63) & ~(uint64_t)63; };
+    const uint32_t rows = dfa.no_state + 1;
+
+    DFAFileHeader hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, DFA_MAGIC, 4);
+    hdr.version = DFA_VERSION;
+    hdr.byteOrder = DFA_BYTE_ORDER;
+    hdr.rows = rows;
+    hdr.no_col = dfa.no_col;
+    hdr.init = dfa.init;
+    hdr.width = dfa.table.width();
+    hdr.alphabetLen = dfa.alphabet.length();
+    hdr.colOffset = align(sizeof(hdr));
+    hdr.acceptOffset = align(hdr.colOffset + 256 * sizeof(uint16_t));
+    hdr.tableOffset = align(hdr.acceptOffset + (rows + 63) / 64 * sizeof(uint64_t));
+    hdr.alphabetOffset = align(hdr.tableOffset + (uint64_t)rows * dfa.no_col * hdr.width);
+    hdr.fileSize = hdr.alphabetOffset + hdr.alphabetLen;
+
+    vector<unsigned char> image(hdr.fileSize, 0);
+    memcpy(image.data(), &hdr, sizeof(hdr));
+
+    memcpy(image.data() + hdr.colOffset, dfa.col, sizeof(dfa.col));
+    // accept holds no_state / 64 + 1 words, one more than the section when
+    // rows is a multiple of 64; copy only what the section has room for
+    size_t acceptWords = min((size_t)(rows + 63) / 64, dfa.accept.size());
+    memcpy(image.data() + hdr.acceptOffset, dfa.accept.data(), acceptWords * sizeof(uint64_t));
+    memcpy(image.data() + hdr.tableOffset, dfa.table.data(), dfa.table.bytes());
+    memcpy(image.data() + hdr.alphabetOffset, dfa.alphabet.data(), hdr.alphabetLen);
+
+    FILE* out = fopen(path, "wb");
+    if (out == NULL) {
+        cerr << "Cannot write file: " << path << endl;
+        return false;
+    }
+    bool ok = fwrite(image.data(), 1, image.size(), out) == image.size();
+    ok = (fclose(out) == 0) && ok;
+    if (!ok) {
+        cerr << "Error writing file: " << path << endl;
+    }
+    return ok;
+}
+
+// Function to map a whole file read-only. Returns false with size 0 if the
+// file cannot be opened, or with its size if it cannot be mapped; an empty
+// file maps to base = NULL with size 0.
+bool mapFile(const char* path, void*& base, size_t& size) {
+    base = NULL;
+    size = 0;
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) return false;
+    LARGE_INTEGER fileSize;
+    GetFileSizeEx(file, &fileSize);
+    size = fileSize.QuadPart;
+    HANDLE mapping = size ? CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL) : NULL;
+    base = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+    if (mapping) CloseHandle(mapping);
+    CloseHandle(file);
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    fstat(fd, &st);
+    size = st.st_size;
+    base = size ? mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0) : NULL;
+    if (base == MAP_FAILED) base = NULL;
+    close(fd);
+#endif
+    return base != NULL || size == 0;
+}
+
+void unmapFile(void* base, size_t size) {
+    if (base == NULL) return;
+#ifdef _WIN32
+    UnmapViewOfFile(base);
+#else
+    munmap(base, size);
+#endif
+}
+
+// Function to bring a whole input into memory for the search and benchmark
+// modes. A regular file is mapped into base; stdin ("-") and files that
+// cannot be mapped, such as pipes, process substitutions and devices, are
+// read to the end into data with base = NULL. size is the byte count either
+// way. Prints the error and returns false if the input cannot be opened.
+bool loadInput(const char* path, void*& base, size_t& size, vector<unsigned char>& data) {
+    base = NULL;
+    size = 0;
+    FILE* in = stdin;
+    if (strcmp(path, "-") == 0) {
+#ifdef _WIN32
+        _setmode(_fileno(stdin), _O_BINARY);
+#endif
+    } else {
+#ifndef _WIN32
+        struct stat st;
+        bool regular = stat(path, &st) == 0 && S_ISREG(st.st_mode);
+#else
+        bool regular = true;
+#endif
+        if (regular) {
+            if (!mapFile(path, base, size)) {
+                cerr << (size == 0 ? "Input file not found: " : "Cannot map file: ") << path << endl;
+                return false;
+            }
+            return true;
+        }
+        in = fopen(path, "rb");
+        if (in == NULL) {
+            cerr << "Input file not found: " << path << endl;
+            return false;
+        }
+    }
+    unsigned char block[1 << 16];
+    size_t n;
+    while ((n = fread(block, 1, sizeof(block), in)) > 0) {
+        data.insert(data.end(), block, block + n);
+    }
+    bool ok = !ferror(in);
+    if (in != stdin) fclose(in);
+    if (!ok) {
+        cerr << "Error reading input: " << path << endl;
+        return false;
+    }
+    size = data.size();
+    return true;
+}
+
+void unmapDFA(MappedDFA& m) {
+    unmapFile(m.base, m.size);
+    m.base = NULL;
+}
+
+// Function to map a compiled DFA file read-only and point the view at its
+// sections. The header, the byte map and the section bounds are checked. The
+// table cells are not: loading never touches the table, so services start
+// without reading it, and a corrupt or hostile file whose cells name states
+// past the last row makes matching read outside the mapping. Only load
+// files written by exportDFA from a trusted source.
+bool mapDFA(const char* path, MappedDFA& m) {
+    if (!mapFile(path, m.base, m.size) && m.size == 0) {
+        cerr << "Compiled DFA not found: " << path << endl;
+        return false;
+    }
+    if (m.base == NULL) {
+        cerr << "Cannot map file: " << path << endl;
+        return false;
+    }
+
+    const unsigned char* base = (const unsigned char*)m.base;
+    const DFAFileHeader* hdr = (const DFAFileHeader*)base;
+    // Section [off, off + len) lies inside the file, tested without overflow
+    auto fits = [&](uint64_t off, uint64_t len) {
+        return off <= hdr->fileSize && len <= hdr->fileSize - off;
+    };
+    bool ok = m.size >= sizeof(DFAFileHeader)
+        && memcmp(hdr->magic, DFA_MAGIC, 4) == 0
+        && hdr->version == DFA_VERSION
+        && hdr->byteOrder == DFA_BYTE_ORDER
+        && hdr->rows > 0 && hdr->no_col > 0 && hdr->no_col <= 65535 && hdr->init < hdr->rows
+        && (hdr->width == 1 || hdr->width == 2 || hdr->width == 4)
+        && (int)hdr->width == cellWidth(hdr->rows)
+        && hdr->fileSize == m.size;
+    if (ok) {
+        uint64_t colBytes = 256 * sizeof(uint16_t);
+        uint64_t acceptBytes = (hdr->rows + (uint64_t)63) / 64 * sizeof(uint64_t);
+        uint64_t tableBytes = (uint64_t)hdr->rows * hdr->no_col * hdr->width;
+        // Every section fits before the sums are formed, so they cannot wrap
+        ok = fits(hdr->colOffset, colBytes) && fits(hdr->acceptOffset, acceptBytes)
+            && fits(hdr->tableOffset, tableBytes) && fits(hdr->alphabetOffset, hdr->alphabetLen)
+            && hdr->colOffset + colBytes <= hdr->acceptOffset
+            && hdr->acceptOffset + acceptBytes <= hdr->tableOffset
+            && hdr->tableOffset + tableBytes <= hdr->alphabetOffset
+            && hdr->colOffset % 64 == 0 && hdr->acceptOffset % 64 == 0 && hdr->tableOffset % 64 == 0;
+    }
+    if (!ok) {
+        cerr << "Not a compatible compiled DFA file: " << path << endl;
+        unmapDFA(m);
+        return false;
+    }
+
+    m.no_state = hdr->rows - 1;
+    m.no_col = hdr->no_col;
+    m.init = hdr->init;
+    m.width = hdr->width;
+    m.col = (const uint16_t*)(base + hdr->colOffset);
+    m.accept = (const uint64_t*)(base + hdr->acceptOffset);
+    m.table = base + hdr->tableOffset;
+    m.alphabet.assign((const char*)base + hdr->alphabetOffset, hdr->alphabetLen);
+    for (int b = 0; b < 256; b++) {
+        if (m.col[b] >= m.no_col) {
+            cerr << "Corrupt byte map in: " << path << endl;
+            unmapDFA(m);
+            return false;
+        }
+    }
+    return true;
+}
+
+// Function to advance a mapped automaton, dispatching once on the cell width
+int stepDFA(const MappedDFA& m, int current, const unsigned char* s, size_t n) {
+    switch (m.width) {
+    case 1: return stepTable((const uint8_t*)m.table, m.col, m.no_col, current, s, n);
+    case 2: return stepTable((const uint16_t*)m.table, m.col, m.no_col, current, s, n);
+    default: return stepTable((const uint32_t*)m.table, m.col, m.no_col, current, s, n);
+    }
+}
+
+bool isAccepting(const MappedDFA& m, int state) {
+    return (m.accept[state / 64] >> (state % 64)) & 1;
+}
+
+// Function to read a DFA definition file. The file holds the same answers the
+// interactive prompts ask for, in the same order: number of symbols, the
+// symbols, number of states, initial state, number of accepting states, the
+// accepting states and the transition table row by row.
+bool loadDFA(const char* path, CompiledDFA& dfa) {
+    ifstream file(path);
+    if (!file.is_open()) {
+        cerr << "Definition file not found: " << path << endl;
+        return false;
+    }
+
+    int no_input, no_state, init, no_accept;
+    if (!(file >> no_input) || no_input <= 0 || no_input >= 65535) {
+        cerr << "Invalid number of input symbols\n";
+        return false;
+    }
+    vector<char> input(no_input);
+    for (int i = 0; i < no_input; i++) {
+        file >> input[i];
+    }
+
+    if (!(file >> no_state >> init) || no_state <= 0 || init <= 0 || init > no_state) {
+        cerr << "Invalid number of states or initial state\n";
+        return false;
+    }
+
+    if (!(file >> no_accept) || no_accept < 0) {
+        cerr << "Invalid number of accepting states\n";
+        return false;
+    }
+    vector<int> accept(no_accept);
+    for (int i = 0; i < no_accept; i++) {
+        if (!(file >> accept[i]) || accept[i] <= 0 || accept[i] > no_state) {
+            cerr << "Invalid Accepting state\n";
+            return false;
+        }
+    }
+
+    vector<int> TT((size_t)no_state * no_input);
+    for (size_t i = 0; i < TT.size(); i++) {
+        if (!(file >> TT[i]) || TT[i] <= 0 || TT[i] > no_state) {
+            cerr << "Invalid State in transition table\n";
+            return false;
+        }
+    }
+
+    dfa = compileDFA(input.data(), no_input, no_state, init,
+                     accept.data(), no_accept, TT.data(), no_input);
+    return true;
+}
+
+// Readable bytes the multi-lane kernels need past the last record (the AVX2
+// kernel gathers 4 bytes at a time)
+const size_t LANE_PAD = 4;
+
+// Function to classify records one at a time; result[i] is 1 if record i
+// (len[i] bytes at buf + start[i]) is accepted
+template <typename Automaton>
+void classifySerial(const Automaton& dfa, const unsigned char* buf, const uint32_t* start,
+                    const uint32_t* len, size_t count, unsigned char* result) {
+    for (size_t i = 0; i < count; i++) {
+        result[i] = isAccepting(dfa, stepDFA(dfa, dfa.init, buf + start[i], len[i]));
+    }
+}
+
+// Extended table for the multi-lane kernels. Each lane walks a run of whole
+// lines, so record boundaries have to be crossed without branching: '\n' gets
+// a column that sends every state back to the initial state, and '\r' moves
+// to a shadow copy of the state (row + rows) so a CRLF line still reports the
+// state reached before its '\r'. result[] holds the verdict for a line that
+// ends in each state.
+//
+// Cells are int whatever the width of the StateTable, because the AVX2
+// kernel gathers 32-bit lanes. With twice the rows and two extra columns the
+// table is up to 8x the size of a 1-byte StateTable, so automata whose lane
+// table outgrows the cache can run faster on the --load path, which steps
+// the narrow cells directly.
+struct LaneTable {
+    int init;
+    int stride;
+    int nlCol;
+    int col[256];
+    vector<int> next;
+    vector<int> result;
+};
+
+LaneTable buildLaneTable(const CompiledDFA& dfa) {
+    const int rows = dfa.no_state + 1;
+    const int k = dfa.no_col;
+    const StateTable& T = dfa.table;
+
+    LaneTable X;
+    X.init = dfa.init;
+    X.stride = k + 2;
+    X.nlCol = k + 1;
+    const int crCol = k;
+    const int crOrig = dfa.col['\r'];
+    for (int b = 0; b < 256; b++) {
+        X.col[b] = dfa.col[b];
+    }
+    X.col['\r'] = crCol;
+    X.col['\n'] = X.nlCol;
+
+    X.next.resize((size_t)2 * rows * X.stride);
+    X.result.resize(2 * rows);
+    for (int st = 0; st < rows; st++) {
+        int* real = &X.next[(size_t)st * X.stride];
+        int* shadow = &X.next[(size_t)(st + rows) * X.stride];
+        int afterCR = T.get((size_t)st * k + crOrig);
+        for (int c = 0; c < k; c++) {
+            real[c] = T.get((size_t)st * k + c);
+            shadow[c] = T.get((size_t)afterCR * k + c);
+        }
+        real[crCol] = st + rows;
+        shadow[crCol] = afterCR + rows;
+        real[X.nlCol] = shadow[X.nlCol] = X.init;
+        X.result[st] = X.result[st + rows] = isAccepting(dfa, st);
+    }
+    return X;
+}
+
+// Function to walk the lines in [p, e) from state s, writing the verdict of
+// each line to result starting at index rec. The verdict store happens on
+// every byte; the one made at a line's '\n' is the last before rec moves on.
+void walkLines(const LaneTable& X, const unsigned char* buf, size_t p, size_t e,
+               size_t rec, int s, unsigned char* result) {
+    for (; p < e; p++) {
+        int c = X.col[buf[p]];
+        result[rec] = X.result[s];
+        rec += (c == X.nlCol);
+        s = X.next[s * X.stride + c];
+    }
+}
+
+// Offset just past the '\n' ending the last record
+size_t linesEnd(const unsigned char* buf, const uint32_t* start, const uint32_t* len, size_t count) {
+    size_t e = start[count - 1] + len[count - 1];
+    if (buf[e] == '\r') e++;
+    return e + 1;
+}
+
+// Function to classify '\n'-terminated lines (start/len as in classifySerial,
+// each record followed by an optional '\r' and a '\n') with 8 interleaved
+// scalar lanes. Each lane owns a contiguous run of lines, so the table loads
+// of different lanes overlap instead of waiting on one dependency chain.
+void classifyInterleaved(const LaneTable& X, const unsigned char* buf, const uint32_t* start,
+                         const uint32_t* len, size_t count, unsigned char* result) {
+    const int L = 8;
+    if (count == 0) return;
+    size_t end = linesEnd(buf, start, len, count);
+    if (count < 4 * L) {
+        walkLines(X, buf, start[0], end, 0, X.init, result);
+        return;
+    }
+
+    size_t p[L], e[L], rec[L];
+    int s[L];
+    for (int l = 0; l < L; l++) {
+        rec[l] = count * l / L;
+        p[l] = start[rec[l]];
+        e[l] = (l + 1 < L) ? start[count * (l + 1) / L] : end;
+        s[l] = X.init;
+    }
+    size_t steps = e[0] - p[0];
+    for (int l = 1; l < L; l++) {
+        steps = min(steps, e[l] - p[l]);
+    }
+
+    const int* next = X.next.data();
+    const int* res = X.result.data();
+    const int stride = X.stride, nlCol = X.nlCol;
+    for (size_t k = 0; k < steps; k++) {
+        for (int l = 0; l < L; l++) {
+            int c = X.col[buf[p[l] + k]];
+            result[rec[l]] = res[s[l]];
+            rec[l] += (c == nlCol);
+            s[l] = next[s[l] * stride + c];
+        }
+    }
+    for (int l = 0; l < L; l++) {
+        walkLines(X, buf, p[l] + steps, e[l], rec[l], s[l], result);
+    }
+}
+
+#ifdef __AVX2__
+// Function to classify lines like classifyInterleaved with 16 lanes held in
+// two AVX2 vectors, using gathers for the byte, column and table loads. Line
+// offsets must fit in 31 bits and buf needs LANE_PAD readable bytes past the
+// last line. Verdicts are written from the lanes that just crossed a '\n'.
+void classifyGather(const LaneTable& X, const unsigned char* buf, const uint32_t* start,
+                    const uint32_t* len, size_t count, unsigned char* result) {
+    const int L = 16;
+    if (count == 0) return;
+    size_t end = linesEnd(buf, start, len, count);
+    if (count < 4 * L) {
+        walkLines(X, buf, start[0], end, 0, X.init, result);
+        return;
+    }
+
+    alignas(32) int s[L], p[L];
+    size_t e[L], rec[L];
+    for (int l = 0; l < L; l++) {
+        rec[l] = count * l / L;
+        p[l] = start[rec[l]];
+        e[l] = (l + 1 < L) ? start[count * (l + 1) / L] : end;
+        s[l] = X.init;
+    }
+    size_t steps = e[0] - p[0];
+    for (int l = 1; l < L; l++) {
+        steps = min(steps, e[l] - p[l]);
+    }
+
+    const __m256i stride = _mm256_set1_epi32(X.stride);
+    const __m256i nlCol = _mm256_set1_epi32(X.nlCol);
+    const __m256i lowByte = _mm256_set1_epi32(0xFF);
+    const __m256i one = _mm256_set1_epi32(1);
+    __m256i s0 = _mm256_load_si256((const __m256i*)s);
+    __m256i s1 = _mm256_load_si256((const __m256i*)(s + 8));
+    __m256i p0 = _mm256_load_si256((const __m256i*)p);
+    __m256i p1 = _mm256_load_si256((const __m256i*)(p + 8));
+
+    for (size_t k = 0; k < steps; k++) {
+        __m256i c0 = _mm256_i32gather_epi32(X.col,
+            _mm256_and_si256(_mm256_i32gather_epi32((const int*)buf, p0, 1), lowByte), 4);
+        __m256i c1 = _mm256_i32gather_epi32(X.col,
+            _mm256_and_si256(_mm256_i32gather_epi32((const int*)buf, p1, 1), lowByte), 4);
+
+        unsigned nl = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(c0, nlCol)))
+                    | _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(c1, nlCol))) << 8;
+        if (nl) {
+            _mm256_store_si256((__m256i*)s, s0);
+            _mm256_store_si256((__m256i*)(s + 8), s1);
+            for (; nl; nl &= nl - 1) {
+                int l = __builtin_ctz(nl);
+                result[rec[l]++] = X.result[s[l]];
+            }
+        }
+
+        s0 = _mm256_i32gather_epi32(X.next.data(), _mm256_add_epi32(_mm256_mullo_epi32(s0, stride), c0), 4);
+        s1 = _mm256_i32gather_epi32(X.next.data(), _mm256_add_epi32(_mm256_mullo_epi32(s1, stride), c1), 4);
+        p0 = _mm256_add_epi32(p0, one);
+        p1 = _mm256_add_epi32(p1, one);
+    }
+
+    _mm256_store_si256((__m256i*)s, s0);
+    _mm256_store_si256((__m256i*)(s + 8), s1);
+    for (int l = 0; l < L; l++) {
+        walkLines(X, buf, p[l] + steps, e[l], rec[l], s[l], result);
+    }
+}
+#endif
+
+// Classifier used by runBatch: records one at a time for any automaton
+template <typename Automaton>
+struct SerialClassifier {
+    const Automaton& dfa;
+
+    void operator()(const unsigned char* buf, const uint32_t* start, const uint32_t* len,
+                    size_t count, unsigned char* result) const {
+        classifySerial(dfa, buf, start, len, count, result);
+    }
+};
+
+// Classifier for in-memory automata: multi-lane kernel over a lane table
+// built once per run
+struct LaneClassifier {
+    LaneTable table;
+
+    void operator()(const unsigned char* buf, const uint32_t* start, const uint32_t* len,
+                    size_t count, unsigned char* result) const {
+#ifdef __AVX2__
+        classifyGather(table, buf, start, len, count, result);
+#else
+        classifyInterleaved(table, buf, start, len, count, result);
+#endif
+    }
+};
+
+template <typename Automaton>
+SerialClassifier<Automaton> makeClassifier(const Automaton& dfa) {
+    return SerialClassifier<Automaton>{dfa};
+}
+
+LaneClassifier makeClassifier(const CompiledDFA& dfa) {
+    return LaneClassifier{buildLaneTable(dfa)};
+}
+
+// Function to find the newline-separated strings of buf[0, size): the start
+// and length of each, without its '\n' or a '\r' before it. A last string
+// with no '\n' after it is included.
+template <typename Index>
+void splitLines(const unsigned char* buf, size_t size, vector<Index>& starts, vector<Index>& lens) {
+    size_t p = 0;
+    while (p < size) {
+        const unsigned char* nl = (const unsigned char*)memchr(buf + p, '\n', size - p);
+        size_t e = nl ? nl - buf : size;
+        size_t len = e - p;
+        if (len > 0 && buf[e - 1] == '\r') len--;
+        starts.push_back(p);
+        lens.push_back(len);
+        p = e + 1;
+    }
+}
+
+// Function to time the one-at-a-time loop against the multi-lane kernels on
+// the newline-separated strings of a file held in memory
+int benchmarkLanes(const CompiledDFA& dfa, const char* path) {
+    FILE* in = fopen(path, "rb");
+    if (in == NULL) {
+        cerr << "Input file not found: " << path << endl;
+        return 1;
+    }
+    vector<unsigned char> buf;
+    unsigned char block[1 << 16];
+    size_t n;
+    while ((n = fread(block, 1, sizeof(block), in)) > 0) {
+        buf.insert(buf.end(), block, block + n);
+    }
+    fclose(in);
+    if (buf.size() >= (1u << 31)) {
+        cerr << "Input too large for 32-bit record offsets\n";
+        return 1;
+    }
+    if (!buf.empty() && buf.back() != '\n') {
+        buf.push_back('\n');  // the lane kernels expect every line terminated
+    }
+    size_t dataSize = buf.size();
+    buf.resize(dataSize + LANE_PAD);
+
+    vector<uint32_t> starts, lens;
+    splitLines(buf.data(), dataSize, starts, lens);
+    size_t count = starts.size();
+
+    LaneTable X = buildLaneTable(dfa);
+    vector<unsigned char> expected(count), got(count);
+    auto time = [&](const char* name, vector<unsigned char>& res, auto kernel) {
+        auto t0 = chrono::steady_clock::now();
+        kernel(buf.data(), starts.data(), lens.data(), count, res.data());
+        chrono::duration<double> secs = chrono::steady_clock::now() - t0;
+        cout << name << count / secs.count() / 1e6 << " M strings/s";
+        if (&res != &expected && res != expected) cout << "  (results differ!)";
+        cout << "\n";
+    };
+
+    cout << "Strings          : " << count << "\n";
+    time("One at a time    : ", expected, [&](auto... args) { classifySerial(dfa, args...); });
+    time("8 scalar lanes   : ", got, [&](auto... args) { classifyInterleaved(X, args...); });
+#ifdef __AVX2__
+    time("16 AVX2 lanes    : ", got, [&](auto... args) { classifyGather(X, args...); });
+#else
+    cout << "16 AVX2 lanes    : not compiled (build with -mavx2)\n";
+#endif
+    return 0;
+}
+
+// Function to read newline-separated strings from a file (or stdin when path
+// is "-") in large blocks, treating CRLF like LF. The automaton's state is
+// carried across block refills, so records are never copied or reassembled:
+// a record that spans blocks is stepped piece by piece and handed to
+// finish(state), while the complete records inside a block are handed in
+// bulk to block(buf, starts, lens, count), with LANE_PAD readable bytes past
+// the block. Records reach the two callbacks in input order.
+template <typename Automaton, typename Finish, typename Block>
+int readRecords(const Automaton& dfa, const char* path, unsigned long long& bytes,
+                Finish finish, Block block) {
+    FILE* in = stdin;
+    if (strcmp(path, "-") != 0) {
+        in = fopen(path, "rb");
+        if (in == NULL) {
+            cerr << "Input file not found: " << path << endl;
+            return 1;
+        }
+    }
+#ifdef _WIN32
+    else {
+        _setmode(_fileno(stdin), _O_BINARY);
+    }
+#endif
+
+    const size_t BUF_SIZE = 1 << 20;
+    vector<unsigned char> buf(BUF_SIZE + LANE_PAD);
+    vector<uint32_t> starts, lens;
+
+    auto current = dfa.init;  // int for table automata, a bit set for BitNFA
+    bool inRecord = false;    // bytes seen since the last newline
+    bool pendingCR = false;   // '\r' held back at a buffer boundary
+    static const unsigned char CR[1] = {'\r'};
+
+    auto finishRecord = [&]() {
+        finish(current);
+        current = dfa.init;
+        inRecord = false;
+    };
+
+    // Step the start of a record that continues into the next block;
+    // a trailing '\r' may be split from its '\n'
+    auto stepTail = [&](const unsigned char* p, const unsigned char* end) {
+        size_t len = end - p;
+        if (len > 0 && end[-1] == '\r') {
+            len--;
+            pendingCR = true;
+        }
+        if (len > 0 || pendingCR) inRecord = true;
+        current = stepDFA(dfa, current, p, len);
+    };
+
+    size_t n;
+    while ((n = fread(buf.data(), 1, BUF_SIZE, in)) > 0) {
+        bytes += n;
+        const unsigned char* p = buf.data();
+        const unsigned char* end = p + n;
+
+        if (pendingCR) {
+            pendingCR = false;
+            if (*p != '\n') {
+                current = stepDFA(dfa, current, CR, 1);
+            }
+        }
+
+        // Finish the record carried over from the previous block
+        const unsigned char* nl = (const unsigned char*)memchr(p, '\n', end - p);
+        if (nl == NULL) {
+            stepTail(p, end);
+            continue;
+        }
+        size_t len = nl - p;
+        if (len > 0 && nl[-1] == '\r') len--;  // treat CRLF like LF
+        current = stepDFA(dfa, current, p, len);
+        finishRecord();
+        p = nl + 1;
+
+        // Hand over the complete records of this block in bulk
+        starts.clear();
+        lens.clear();
+        while ((nl = (const unsigned char*)memchr(p, '\n', end - p)) != NULL) {
+            len = nl - p;
+            if (len > 0 && nl[-1] == '\r') len--;
+            starts.push_back(p - buf.data());
+            lens.push_back(len);
+            p = nl + 1;
+        }
+        block(buf.data(), starts.data(), lens.data(), starts.size());
+
+        stepTail(p, end);
+    }
+    if (pendingCR) {
+        current = stepDFA(dfa, current, CR, 1);
+    }
+    if (inRecord) {
+        finishRecord();
+    }
+
+    if (in != stdin) {
+        fclose(in);
+    }
+    return 0;
+}
+
+// Function to classify newline-separated strings from a file (or stdin when
+// path is "-") without any per-string iostream work
+template <typename Automaton>
+int runBatch(const Automaton& dfa, const char* path, bool countOnly) {
+    const size_t BUF_SIZE = 1 << 20;
+    vector<char> out;
+    out.reserve(BUF_SIZE + 16);
+    vector<unsigned char> results;
+    auto classify = makeClassifier(dfa);
+
+    unsigned long long total = 0, accepted = 0, bytes = 0;
+
+    auto emit = [&](bool ok) {
+        total++;
+        accepted += ok;
+        if (!countOnly) {
+            const char* res = ok ? "accept\n" : "reject\n";
+            out.insert(out.end(), res, res + 7);
+            if (out.size() >= BUF_SIZE) {
+                fwrite(out.data(), 1, out.size(), stdout);
+                out.clear();
+            }
+        }
+    };
+
+    auto start = chrono::steady_clock::now();
+    int rc = readRecords(dfa, path, bytes,
+        [&](auto state) { emit(isAccepting(dfa, state)); },
+        [&](const unsigned char* buf, const uint32_t* starts, const uint32_t* lens, size_t count) {
+            results.resize(count);
+            classify(buf, starts, lens, count, results.data());
+            for (unsigned char ok : results) {
+                emit(ok);
+            }
+        });
+    if (rc != 0) return rc;
+    chrono::duration<double> secs = chrono::steady_clock::now() - start;
+
+    if (!out.empty()) {
+        fwrite(out.data(), 1, out.size(), stdout);
+    }
+
+    if (countOnly) {
+        printf("Strings : %llu\nAccepted: %llu\nRejected: %llu\n",
+               total, accepted, total - accepted);
+    }
+    fprintf(stderr, "%llu strings, %.1f MB in %.3f s (%.1f MB/s)\n",
+            total, bytes / 1e6, secs.count(), bytes / 1e6 / secs.count());
+    return 0;
+}
+
+// Function to run one chunk from every state at once (enumerative execution).
+// result[s] receives the state reached when the chunk is entered in state s.
+// Lanes that reach the same state are merged, so after a few bytes most
+// automata are down to one lane and run at the serial speed.
+void runChunkAllStates(const CompiledDFA& dfa, const unsigned char* s, size_t n,
+                       vector<int>& result) {
+    const int total = dfa.no_state + 1;
+    const uint16_t* col = dfa.col;
+    const int stride = dfa.no_col;
+
+    vector<int> lane(total), owner(total), laneOf(total, -1);
+    iota(lane.begin(), lane.end(), 0);
+    iota(owner.begin(), owner.end(), 0);  // start state -> lane
+
+    size_t i = 0;
+    while (i < n && lane.size() > 1) {
+        size_t end = min(n, i + 1024);
+        withCells(dfa.table, [&](auto T) {
+            for (; i < end; i++) {
+                int c = col[s[i]];
+                for (int& st : lane) {
+                    st = T[(size_t)st * stride + c];
+                }
+            }
+        });
+
+        // Merge converged lanes
+        vector<int> merged, remap(lane.size());
+        for (size_t l = 0; l < lane.size(); l++) {
+            if (laneOf[lane[l]] < 0) {
+                laneOf[lane[l]] = merged.size();
+                merged.push_back(lane[l]);
+            }
+            remap[l] = laneOf[lane[l]];
+        }
+        for (int st : merged) laneOf[st] = -1;
+        for (int& o : owner) o = remap[o];
+        lane.swap(merged);
+    }
+    if (i < n) {
+        lane[0] = stepDFA(dfa, lane[0], s + i, n - i);
+    }
+
+    result.resize(total);
+    for (int st = 0; st < total; st++) {
+        result[st] = lane[owner[st]];
+    }
+}
+
+// Function to run the automaton over one large file split into chunks. The
+// first chunk of each block starts from the known state; every other chunk is
+// run from all states on its own thread, and the per-chunk state maps are
+// composed in order to get the final state.
+int runParallel(const CompiledDFA& dfa, const char* path, int threads, bool compare) {
+    FILE* in = fopen(path, "rb");
+    if (in == NULL) {
+        cerr << "Input file not found: " << path << endl;
+        return 1;
+    }
+
+    const size_t CHUNK = 32 << 20;
+    vector<unsigned char> buf(CHUNK * threads);
+    vector<vector<int>> maps(threads);
+    unsigned long long bytes = 0;
+    int current = dfa.init;
+    double readSecs = 0, runSecs = 0;
+
+    while (true) {
+        auto readStart = chrono::steady_clock::now();
+        size_t n = fread(buf.data(), 1, buf.size(), in);
+        auto runStart = chrono::steady_clock::now();
+        readSecs += chrono::duration<double>(runStart - readStart).count();
+        if (n == 0) break;
+        bytes += n;
+
+        size_t chunk = (n + threads - 1) / threads;
+        int used = (n + chunk - 1) / chunk;
+        vector<thread> pool;
+        int first = current;
+        for (int t = 1; t < used; t++) {
+            size_t off = t * chunk;
+            size_t len = min(chunk, n - off);
+            pool.emplace_back(runChunkAllStates, cref(dfa), buf.data() + off, len, ref(maps[t]));
+        }
+        current = stepDFA(dfa, first, buf.data(), min(chunk, n));
+        for (thread& th : pool) {
+            th.join();
+        }
+        for (int t = 1; t < used; t++) {
+            current = maps[t][current];
+        }
+        runSecs += chrono::duration<double>(chrono::steady_clock::now() - runStart).count();
+    }
+
+    cout << "Input size : " << bytes / 1e6 << " MB\n";
+    cout << "Threads    : " << threads << "\n";
+    cout << "Parallel   : " << runSecs << " s (" << bytes / 1e6 / runSecs << " MB/s), "
+         << readSecs << " s reading\n";
+    cout << (isAccepting(dfa, current) ? "Valid String\n" : "Invalid String\n");
+
+    if (compare) {
+        rewind(in);
+        int serial = dfa.init;
+        double serialSecs = 0;
+        size_t n;
+        while ((n = fread(buf.data(), 1, buf.size(), in)) > 0) {
+            auto start = chrono::steady_clock::now();
+            serial = stepDFA(dfa, serial, buf.data(), n);
+            serialSecs += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        }
+        cout << "Serial     : " << serialSecs << " s (" << bytes / 1e6 / serialSecs << " MB/s), "
+             << "speedup " << serialSecs / runSecs << "x\n";
+        if (serial != current) {
+            cout << "Warning: serial and parallel runs disagree on final state\n";
+        }
+    }
+    fclose(in);
+    return 0;
+}
+
+// Product of several compiled automata run in one pass. A product state is
+// the tuple of component states; states and transitions are built the first
+// time the input reaches them, so only reachable tuples are ever stored.
+// Bytes that every component maps to the same columns share a product column.
+const int MAX_PRODUCT = 64;
+enum ProductMode { PRODUCT_ANY, PRODUCT_ALL, PRODUCT_WHICH };
+
+struct ProductDFA {
+    vector<const CompiledDFA*> parts;   // must outlive the product
+    ProductMode mode;
+    int init = 0;
+    int dead = 0;                        // every component in its dead state
+    int no_col = 0;
+    uint16_t col[256];
+    vector<unsigned char> colByte;       // a byte of each product column
+
+    mutable vector<int> tuples;          // states * parts.size() component states
+    mutable vector<uint64_t> mask;       // components accepting in each state
+    mutable vector<int> next;            // states * no_col targets, -1 = not built yet
+    mutable map<vector<int>, int> ids;
+
+    int intern(const vector<int>& tuple) const {
+        auto it = ids.emplace(tuple, (int)mask.size());
+        if (!it.second) return it.first->second;
+        uint64_t m = 0;
+        for (size_t k = 0; k < parts.size(); k++) {
+            if (isAccepting(*parts[k], tuple[k])) m |= (uint64_t)1 << k;
+        }
+        tuples.insert(tuples.end(), tuple.begin(), tuple.end());
+        mask.push_back(m);
+        next.resize(next.size() + no_col, -1);
+        return it.first->second;
+    }
+
+    int build(int state, int c) const {
+        const size_t k = parts.size();
+        vector<int> tuple(k);
+        for (size_t i = 0; i < k; i++) {
+            const CompiledDFA& d = *parts[i];
+            int st = tuples[(size_t)state * k + i];
+            tuple[i] = d.table.get((size_t)st * d.no_col + d.col[colByte[c]]);
+        }
+        int t = intern(tuple);
+        next[(size_t)state * no_col + c] = t;
+        return t;
+    }
+
+    int states() const { return mask.size(); }
+};
+
+// Function to set up the product of up to MAX_PRODUCT automata
+ProductDFA makeProduct(const vector<CompiledDFA>& dfas, ProductMode mode) {
+    ProductDFA P;
+    P.mode = mode;
+    for (const CompiledDFA& d : dfas) {
+        P.parts.push_back(&d);
+    }
+
+    map<vector<int>, int> colOf;
+    vector<int> cols(dfas.size());
+    for (int b = 0; b < 256; b++) {
+        for (size_t k = 0; k < dfas.size(); k++) {
+            cols[k] = dfas[k].col[b];
+        }
+        auto it = colOf.emplace(cols, (int)P.colByte.size());
+        if (it.second) P.colByte.push_back(b);
+        P.col[b] = it.first->second;
+    }
+    P.no_col = P.colByte.size();
+
+    vector<int> tuple(dfas.size());
+    for (size_t k = 0; k < dfas.size(); k++) tuple[k] = dfas[k].init;
+    P.init = P.intern(tuple);
+    for (size_t k = 0; k < dfas.size(); k++) tuple[k] = dfas[k].no_state;
+    P.dead = P.intern(tuple);
+    return P;
+}
+
+// Function to advance the product over a buffer, building missing
+// transitions on the way; once every component is dead nothing can change
+int stepDFA(const ProductDFA& P, int current, const unsigned char* s, size_t n) {
+    for (size_t i = 0; i < n && current != P.dead; i++) {
+        int c = P.col[s[i]];
+        int t = P.next[(size_t)current * P.no_col + c];
+        current = t >= 0 ? t : P.build(current, c);
+    }
+    return current;
+}
+
+uint64_t acceptedMask(const ProductDFA& P, int state) {
+    return P.mask[state];
+}
+
+// Union (any component accepts) or intersection (all accept); for
+// PRODUCT_WHICH the mask itself is reported by runWhich
+bool isAccepting(const ProductDFA& P, int state) {
+    if (P.mode == PRODUCT_ALL) {
+        uint64_t all = P.parts.size() == 64 ? ~(uint64_t)0 : ((uint64_t)1 << P.parts.size()) - 1;
+        return P.mask[state] == all;
+    }
+    return P.mask[state] != 0;
+}
+
+// Function to report, for each newline-separated string, which automata of
+// the product accept it (1-based numbers, "-" for none), or with countOnly
+// how many strings each automaton accepted
+int runWhich(const ProductDFA& P, const char* path, bool countOnly) {
+    const size_t BUF_SIZE = 1 << 20;
+    string out;
+    vector<unsigned long long> counts(P.parts.size(), 0);
+    unsigned long long total = 0, bytes = 0;
+
+    auto finishRecord = [&](int state) {
+        uint64_t m = acceptedMask(P, state);
+        total++;
+        for (size_t k = 0; k < P.parts.size(); k++) {
+            if ((m >> k) & 1) {
+                counts[k]++;
+                if (!countOnly) {
+                    if (out.size() > 0 && out.back() != '\n') out += ' ';
+                    out += to_string(k + 1);
+                }
+            }
+        }
+        if (!countOnly) {
+            if (m == 0) out += '-';
+            out += '\n';
+            if (out.size() >= BUF_SIZE) {
+                fwrite(out.data(), 1, out.size(), stdout);
+                out.clear();
+            }
+        }
+    };
+
+    auto start = chrono::steady_clock::now();
+    int rc = readRecords(P, path, bytes, finishRecord,
+        [&](const unsigned char* buf, const uint32_t* starts, const uint32_t* lens, size_t count) {
+            for (size_t i = 0; i < count; i++) {
+                finishRecord(stepDFA(P, P.init, buf + starts[i], lens[i]));
+            }
+        });
+    if (rc != 0) return rc;
+    chrono::duration<double> secs = chrono::steady_clock::now() - start;
+
+    fwrite(out.data(), 1, out.size(), stdout);
+
+    if (countOnly) {
+        printf("Strings : %llu\n", total);
+        for (size_t k = 0; k < counts.size(); k++) {
+            printf("DFA %zu   : %llu accepted\n", k + 1, counts[k]);
+        }
+    }
+    fprintf(stderr, "%llu strings, %.1f MB in %.3f s (%.1f MB/s), %d product states\n",
+            total, bytes / 1e6, secs.count(), bytes / 1e6 / secs.count(), P.states());
+    return 0;
+}
+
+// Function to split the 256 bytes into classes both automata treat alike and
+// return one byte per class, printable where the class has one so that
+// counterexamples stay readable
+vector<unsigned char> jointClasses(const CompiledDFA& a, const CompiledDFA& b) {
+    map<pair<int, int>, int> classOf;
+    vector<unsigned char> rep;
+    for (int c = 0; c < 256; c++) {
+        // Visit printable bytes first so they become the representatives
+        int byte = (c + 32) % 256;
+        auto it = classOf.emplace(make_pair(a.col[byte], b.col[byte]), (int)rep.size());
+        if (it.second) rep.push_back(byte);
+    }
+    return rep;
+}
+
+struct UnionFind {
+    vector<int> parent;
+
+    explicit UnionFind(int n) : parent(n) { iota(parent.begin(), parent.end(), 0); }
+
+    int find(int x) {
+        while (parent[x] != x) {
+            parent[x] = parent[parent[x]];
+            x = parent[x];
+        }
+        return x;
+    }
+
+    bool unite(int x, int y) {
+        x = find(x);
+        y = find(y);
+        if (x == y) return false;
+        parent[x] = y;
+        return true;
+    }
+};
+
+// Function to decide whether two automata accept the same language with
+// Hopcroft and Karp's algorithm: states of both are merged in one union-find
+// as pairs are assumed equal, so each state is expanded at most once and the
+// run is near-linear in (states of a + states of b) x byte classes
+bool sameLanguage(const CompiledDFA& a, const CompiledDFA& b, const vector<unsigned char>& rep) {
+    const int na = a.no_state + 1;
+    UnionFind uf(na + b.no_state + 1);
+    vector<pair<int, int>> work;
+    uf.unite(a.init, na + b.init);
+    work.push_back({a.init, b.init});
+    while (!work.empty()) {
+        int p = work.back().first, q = work.back().second;
+        work.pop_back();
+        if (isAccepting(a, p) != isAccepting(b, q)) return false;
+        for (unsigned char byte : rep) {
+            int p2 = a.table.get((size_t)p * a.no_col + a.col[byte]);
+            int q2 = b.table.get((size_t)q * b.no_col + b.col[byte]);
+            if (uf.unite(p2, na + q2)) work.push_back({p2, q2});
+        }
+    }
+    return true;
+}
+
+// Function to find a shortest string leading to a pair of states for which
+// bad(p, q) holds, by breadth-first search over the reachable state pairs.
+// Returns false if there is none.
+template <typename Bad>
+bool shortestWitness(const CompiledDFA& a, const CompiledDFA& b, const vector<unsigned char>& rep,
+                     Bad bad, string& witness) {
+    const uint64_t nb = b.no_state + 1;
+    unordered_map<uint64_t, int> seen;
+    vector<int> p, q, parent;
+    vector<unsigned char> via;
+    seen.emplace(a.init * nb + b.init, 0);
+    p.push_back(a.init);
+    q.push_back(b.init);
+    parent.push_back(-1);
+    via.push_back(0);
+
+    for (size_t h = 0; h < p.size(); h++) {
+        if (bad(p[h], q[h])) {
+            witness.clear();
+            for (int i = h; parent[i] >= 0; i = parent[i]) {
+                witness += (char)via[i];
+            }
+            reverse(witness.begin(), witness.end());
+            return true;
+        }
+        for (unsigned char byte : rep) {
+            int p2 = a.table.get((size_t)p[h] * a.no_col + a.col[byte]);
+            int q2 = b.table.get((size_t)q[h] * b.no_col + b.col[byte]);
+            if (seen.emplace(p2 * nb + q2, (int)p.size()).second) {
+                p.push_back(p2);
+                q.push_back(q2);
+                parent.push_back(h);
+                via.push_back(byte);
+            }
+        }
+    }
+    return false;
+}
+
+// Function to check L(a) == L(b); when they differ, witness is a shortest
+// string accepted by exactly one of them
+bool equivalentDFA(const CompiledDFA& a, const CompiledDFA& b, string& witness) {
+    vector<unsigned char> rep = jointClasses(a, b);
+    if (sameLanguage(a, b, rep)) return true;
+    shortestWitness(a, b, rep, [&](int p, int q) {
+        return isAccepting(a, p) != isAccepting(b, q);
+    }, witness);
+    return false;
+}
+
+// Function to check L(a) is contained in L(b); when it is not, witness is a
+// shortest string accepted by a but not by b
+bool includedDFA(const CompiledDFA& a, const CompiledDFA& b, string& witness) {
+    vector<unsigned char> rep = jointClasses(a, b);
+    if (sameLanguage(a, b, rep)) return true;
+    return !shortestWitness(a, b, rep, [&](int p, int q) {
+        return isAccepting(a, p) && !isAccepting(b, q);
+    }, witness);
+}
+
+// Function to write a string in double quotes with unprintable bytes escaped
+string quoted(const string& s) {
+    string out = "\"";
+    char hex[8];
+    for (unsigned char c : s) {
+        if (c >= 32 && c < 127 && c != '"' && c != '\\') {
+            out += c;
+        } else {
+            snprintf(hex, sizeof(hex), "\\x%02x", c);
+            out += hex;
+        }
+    }
+    return out + "\"";
+}
+
+// Function to compare two automata from files: "equal" checks equivalence,
+// "subset" checks that every string the first accepts the second accepts.
+// Returns 0 when the relation holds and 2 when a counterexample was found.
+int checkDFAs(const char* relation, const char* pathA, const char* pathB) {
+    CompiledDFA a, b;
+    if (!loadDFA(pathA, a) || !loadDFA(pathB, b)) return 1;
+
+    bool subset = strcmp(relation, "subset") == 0;
+    string witness;
+    auto start = chrono::steady_clock::now();
+    bool holds = subset ? includedDFA(a, b, witness) : equivalentDFA(a, b, witness);
+    chrono::duration<double> secs = chrono::steady_clock::now() - start;
+
+    if (holds) {
+        cout << (subset ? "Included" : "Equivalent") << "\n";
+    } else {
+        bool inA = acceptsDFA(a, witness);
+        cout << (subset ? "Not included" : "Not equivalent") << ", counterexample: "
+             << quoted(witness) << " (accepted by " << (inA ? pathA : pathB) << " only)\n";
+    }
+    fprintf(stderr, "%d + %d states checked in %.3f ms\n",
+            a.no_state + 1, b.no_state + 1, secs.count() * 1e3);
+    return holds ? 0 : 2;
+}
+
+// Positions first..last at which the automaton is in state
+struct StateRun {
+    size_t first, last;
+    int state;
+};
+
+// Function to find every leftmost-longest, non-empty match of the automaton
+// in buf and pass (offset, length) to report. Matches cannot start on a byte
+// that takes the initial state to the dead state, so those bytes are skipped
+// with the vector range scan before the automaton is started; inside a match
+// runs of self-loop bytes are skipped the same way. Returns the match count.
+//
+// An attempt runs until the dead state or the end of buf, and the states it
+// passes after its last accepting position can never reach another one. Those
+// (position, state) pairs are kept as runs in proven, and a later attempt that
+// meets one stops there. So a restart inside a stretch an earlier attempt
+// already covered ends as soon as it falls into that attempt's state. That is
+// at once for self-loop runs such as a*b over a file of a's, which no longer
+// rescan the run from every start.
+template <typename Report>
+size_t searchDFA(const CompiledDFA& dfa, const unsigned char* buf, size_t n, Report report) {
+    const int dead = dfa.no_state;
+    bool skip[256];
+    for (int b = 0; b < 256; b++) {
+        skip[b] = dfa.table.get((size_t)dfa.init * dfa.no_col + dfa.col[b]) == (uint32_t)dead;
+    }
+    SelfLoop skipper{};
+    bool vectorSkip = setRanges(skip, skipper) <= MAX_LOOP_RANGES;
+
+    return withCells(dfa.table, [&](auto T) {
+        const SelfLoop* loops = dfa.loops.empty() ? NULL : dfa.loops.data();
+        deque<StateRun> proven;    // ascending positions, all past the last match
+        vector<StateRun> tail;     // this attempt's states after its last accept
+        auto record = [&](size_t from, size_t to, int st) {
+            if (!tail.empty() && tail.back().state == st && tail.back().last + 1 == from) tail.back().last = to;
+            else tail.push_back({from, to, st});
+        };
+
+        size_t count = 0, i = 0;
+        while (i < n) {
+            if (vectorSkip) {
+                i += loopRun(skipper, buf + i, n - i);
+            } else {
+                while (i < n && skip[buf[i]]) i++;
+            }
+            if (i == n) break;
+
+            int st = dfa.init;
+            size_t j = i, last = i;
+            size_t next = 0;       // first run of proven that may hold j
+            tail.clear();
+            while (j < n) {
+                while (next < proven.size() && proven[next].last < j) next++;
+                if (next < proven.size() && proven[next].first <= j && proven[next].state == st) break;
+
+                if (loops && loops[st].kind == LOOP_ALL) {
+                    if (isAccepting(dfa, st)) last = n;  // accepts any continuation
+                    break;
+                }
+                if (loops && loops[st].kind == LOOP_RANGES) {
+                    size_t run = loopRun(loops[st], buf + j, n - j);
+                    if (run > 0) record(j + 1, j + run, st);
+                    j += run;
+                    if (isAccepting(dfa, st)) {
+                        last = j;
+                        tail.clear();
+                    }
+                    if (j == n) break;
+                }
+                st = T[(size_t)st * dfa.no_col + dfa.col[buf[j++]]];
+                if (st == dead) break;
+                if (isAccepting(dfa, st)) {
+                    last = j;
+                    tail.clear();
+                } else {
+                    record(j, j, st);
+                }
+            }
+
+            // Later attempts start at or after last, so only the pairs past
+            // it are kept; the new ones replace any already held there
+            size_t end = tail.empty() ? last : tail.back().last;
+            while (!proven.empty() && proven.front().last <= end) proven.pop_front();
+            if (!proven.empty() && proven.front().first <= end) proven.front().first = end + 1;
+            for (size_t k = tail.size(); k-- > 0;) proven.push_front(tail[k]);
+
+            if (last > i) {
+                report(i, last - i);
+                count++;
+                i = last;
+            } else {
+                i++;
+            }
+        }
+        return count;
+    });
+}
+
+// Function to search a file (mapped, or read into memory) and print
+// "offset length" for every match, or only the number of matches
+int runSearch(const CompiledDFA& dfa, const char* path, bool countOnly) {
+    void* base = NULL;
+    size_t size = 0;
+    vector<unsigned char> data;
+    if (!loadInput(path, base, size, data)) return 1;
+    const unsigned char* buf = base ? (const unsigned char*)base : data.data();
+    size_t n = size;
+
+    string out;
+    char line[48];
+    auto start = chrono::steady_clock::now();
+    size_t matches = searchDFA(dfa, buf, n, [&](size_t offset, size_t len) {
+        if (countOnly) return;
+        int k = snprintf(line, sizeof(line), "%zu %zu\n", offset, len);
+        out.append(line, k);
+        if (out.size() >= (1 << 20)) {
+            fwrite(out.data(), 1, out.size(), stdout);
+            out.clear();
+        }
+    });
+    chrono::duration<double> secs = chrono::steady_clock::now() - start;
+    fwrite(out.data(), 1, out.size(), stdout);
+    unmapFile(base, size);
+
+    if (countOnly) {
+        printf("Matches : %zu\n", matches);
+    }
+    fprintf(stderr, "%zu matches, %.1f MB in %.3f s (%.1f MB/s)\n",
+            matches, n / 1e6, secs.count(), n / 1e6 / secs.count());
+    return 0;
+}
+
+// Hardware event counter for the calling thread, read with perf_event_open
+// on Linux. Elsewhere, or where the kernel refuses access, available() is
+// false and the benchmark reports timings only.
+class PerfCounter {
+public:
+    enum Event { L1D_READ_MISSES, CACHE_MISSES };
+
+    explicit PerfCounter(Event event) {
+#ifdef __linux__
+        perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        if (event == L1D_READ_MISSES) {
+            attr.type = PERF_TYPE_HW_CACHE;
+            attr.config = PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+                        | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        } else {
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_CACHE_MISSES;
+        }
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        fd = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+#else
+        (void)event;
+#endif
+    }
+
+    ~PerfCounter() {
+#ifdef __linux__
+        if (fd >= 0) close(fd);
+#endif
+    }
+
+    bool available() const { return fd >= 0; }
+
+    void start() {
+#ifdef __linux__
+        if (fd < 0) return;
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+#endif
+    }
+
+    long long stop() {
+        long long count = -1;
+#ifdef __linux__
+        if (fd < 0) return -1;
+        ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        if (read(fd, &count, sizeof(count)) != sizeof(count)) count = -1;
+#endif
+        return count;
+    }
+
+private:
+    int fd = -1;
+};
+
+// Visit counts from running the automaton over training records
+struct DFAProfile {
+    vector<uint64_t> visits;   // steps taken out of each state
+    vector<uint64_t> columns;  // steps taken on each column
+};
+
+DFAProfile profileDFA(const CompiledDFA& dfa, const unsigned char* buf,
+                      const vector<size_t>& starts, const vector<size_t>& lens) {
+    DFAProfile prof;
+    prof.visits.assign(dfa.no_state + 1, 0);
+    prof.columns.assign(dfa.no_col, 0);
+    withCells(dfa.table, [&](auto T) {
+        for (size_t r = 0; r < starts.size(); r++) {
+            int st = dfa.init;
+            for (size_t i = starts[r]; i < starts[r] + lens[r]; i++) {
+                int c = dfa.col[buf[i]];
+                prof.visits[st]++;
+                prof.columns[c]++;
+                st = T[(size_t)st * dfa.no_col + c];
+            }
+        }
+    });
+    return prof;
+}
+
+// Function to renumber states and columns in place: state s becomes
+// stateId[s] and column c becomes colId[c]. The dead state must map to the
+// last row.
+void permuteDFA(CompiledDFA& dfa, const vector<int>& stateId, const vector<int>& colId) {
+    const int rows = dfa.no_state + 1, k = dfa.no_col;
+    StateTable table;
+    table.assign((size_t)rows * k, rows, 0);
+    vector<uint64_t> accept(dfa.accept.size(), 0);
+    vector<SelfLoop> loops(dfa.loops.size());
+    for (int s = 0; s < rows; s++) {
+        for (int c = 0; c < k; c++) {
+            table.set((size_t)stateId[s] * k + colId[c], stateId[dfa.table.get((size_t)s * k + c)]);
+        }
+        if (isAccepting(dfa, s)) setAccepting(accept, stateId[s]);
+        if (!loops.empty()) loops[stateId[s]] = dfa.loops[s];
+    }
+    for (int b = 0; b < 256; b++) {
+        dfa.col[b] = colId[dfa.col[b]];
+    }
+    dfa.init = stateId[dfa.init];
+    dfa.table = move(table);
+    dfa.accept.swap(accept);
+    dfa.loops.swap(loops);
+}
+
+// Function to lay the automaton out by profile: states in falling order of
+// visits, so the rows the input keeps returning to share cache lines and
+// pages, and columns in falling order of use, so the hot cells sit at the
+// front of every row. The dead state stays last.
+void renumberByProfile(CompiledDFA& dfa, const DFAProfile& prof) {
+    const int rows = dfa.no_state + 1;
+    vector<int> byHeat(rows - 1), cols(dfa.no_col);
+    iota(byHeat.begin(), byHeat.end(), 0);
+    iota(cols.begin(), cols.end(), 0);
+    stable_sort(byHeat.begin(), byHeat.end(), [&](int a, int b) { return prof.visits[a] > prof.visits[b]; });
+    stable_sort(cols.begin(), cols.end(), [&](int a, int b) { return prof.columns[a] > prof.columns[b]; });
+
+    vector<int> stateId(rows), colId(dfa.no_col);
+    for (int i = 0; i < rows - 1; i++) stateId[byHeat[i]] = i;
+    stateId[rows - 1] = rows - 1;
+    for (int i = 0; i < dfa.no_col; i++) colId[cols[i]] = i;
+    permuteDFA(dfa, stateId, colId);
+}
+
+// Function to profile the automaton on the newline-separated strings of a
+// training file, renumber it, and compare time and cache misses of both
+// layouts on the same strings. With outPath the renumbered automaton is
+// exported for --load.
+int profileAndRenumber(CompiledDFA& dfa, const char* path, const char* outPath) {
+    void* base = NULL;
+    size_t size = 0;
+    vector<unsigned char> data;
+    if (!loadInput(path, base, size, data)) return 1;
+    const unsigned char* buf = base ? (const unsigned char*)base : data.data();
+    vector<size_t> starts, lens;
+    splitLines(buf, size, starts, lens);
+
+    CompiledDFA tuned = dfa;
+    DFAProfile prof = profileDFA(dfa, buf, starts, lens);
+    renumberByProfile(tuned, prof);
+
+    vector<uint64_t> heat(prof.visits.begin(), prof.visits.end() - 1);
+    sort(heat.rbegin(), heat.rend());
+    uint64_t total = accumulate(heat.begin(), heat.end(), (uint64_t)0), seen = 0;
+    size_t hot = 0;
+    while (hot < heat.size() && seen * 10 < total * 9) seen += heat[hot++];
+    cout << "Hot states       : " << hot << " of " << dfa.no_state + 1
+         << " states take 90% of the steps\n";
+
+    PerfCounter l1(PerfCounter::L1D_READ_MISSES);
+    PerfCounter llc(PerfCounter::CACHE_MISSES);
+    auto measure = [&](const char* name, const CompiledDFA& d) {
+        l1.start();
+        llc.start();
+        auto t0 = chrono::steady_clock::now();
+        size_t accepted = 0;
+        for (size_t r = 0; r < starts.size(); r++) {
+            accepted += isAccepting(d, stepDFA(d, d.init, buf + starts[r], lens[r]));
+        }
+        chrono::duration<double> secs = chrono::steady_clock::now() - t0;
+        long long l1Misses = l1.stop(), llcMisses = llc.stop();
+        cout << name << size / 1e6 / secs.count() << " MB/s";
+        if (l1Misses >= 0) cout << ", L1D misses " << l1Misses;
+        if (llcMisses >= 0) cout << ", cache misses " << llcMisses;
+        cout << " (" << accepted << " accepted)\n";
+    };
+
+    cout << "Strings          : " << starts.size() << "\n";
+    measure("Original layout  : ", dfa);
+    measure("Profiled layout  : ", tuned);
+    if (!l1.available() && !llc.available()) {
+        cout << "Cache-miss counters unavailable (perf events not permitted here)\n";
+    }
+    unmapFile(base, size);
+    return outPath ? (exportDFA(tuned, outPath) ? 0 : 1) : 0;
+}
+
+// Read-only automaton for sharing between threads. The constructor runs the
+// same minimise / byte-class / self-loop pipeline as the command-line modes;
+// afterwards nothing is modified, and match() only reads the table, so any
+// number of threads may call it on one object with no locks and no
+// allocation.
+class Dfa {
+public:
+    explicit Dfa(CompiledDFA compiled) : dfa(move(compiled)) {
+        minimizeDFA(dfa);
+        compressColumns(dfa);
+        findSelfLoops(dfa);
+    }
+
+    bool match(string_view s) const noexcept {
+        return isAccepting(dfa, stepDFA(dfa, dfa.init, (const unsigned char*)s.data(), s.size()));
+    }
+
+    const CompiledDFA& compiled() const { return dfa; }
+
+private:
+    CompiledDFA dfa;
+};
+
+// Function to match the strings of a file against one shared Dfa from 1, 2,
+// 4, ... maxThreads workers. Each worker takes an equal slice of the strings
+// and counts into its own cache line; the strings/s for every worker count
+// show how throughput scales.
+int benchmarkThreads(const Dfa& dfa, const char* path, int maxThreads) {
+    void* base = NULL;
+    size_t size = 0;
+    vector<unsigned char> data;
+    if (!loadInput(path, base, size, data)) return 1;
+    const char* buf = base ? (const char*)base : (const char*)data.data();
+    vector<size_t> starts, lens;
+    splitLines((const unsigned char*)buf, size, starts, lens);
+    vector<string_view> strings;
+    for (size_t i = 0; i < starts.size(); i++) {
+        strings.emplace_back(buf + starts[i], lens[i]);
+    }
+
+    struct alignas(64) Slot {
+        size_t accepted;
+    };
+    const int ROUNDS = 5;
+    cout << "Strings          : " << strings.size() << " x " << ROUNDS << " rounds\n";
+    double single = 0;
+    for (int threads = 1; threads <= maxThreads; threads *= 2) {
+        vector<Slot> slots(threads);
+        vector<thread> workers;
+        auto t0 = chrono::steady_clock::now();
+        for (int w = 0; w < threads; w++) {
+            workers.emplace_back([&, w] {
+                size_t from = strings.size() * w / threads, to = strings.size() * (w + 1) / threads;
+                size_t accepted = 0;
+                for (int r = 0; r < ROUNDS; r++) {
+                    for (size_t i = from; i < to; i++) {
+                        accepted += dfa.match(strings[i]);
+                    }
+                }
+                slots[w].accepted = accepted;
+            });
+        }
+        for (thread& t : workers) t.join();
+        chrono::duration<double> secs = chrono::steady_clock::now() - t0;
+
+        size_t accepted = 0;
+        for (const Slot& s : slots) accepted += s.accepted;
+        double rate = strings.size() * ROUNDS / secs.count() / 1e6;
+        if (threads == 1) single = rate;
+        printf("%3d thread(s)    : %.2f M strings/s, %.2fx (%zu accepted)\n",
+               threads, rate, rate / single, accepted / ROUNDS);
+    }
+    unmapFile(base, size);
+    return 0;
+}
+
+// Function to compare the runtime-table path against the compile-time
+// identifier automaton on the same random input
+void benchmarkStatic(size_t mb) {
+    CompiledDFA dfa = compileDFA(TC3_INPUT, 36, TC3_STATES, TC3_INIT,
+                                 TC3_ACCEPT, 1, &TC3_TT[0][0], 36);
+    minimizeDFA(dfa);
+
+    const size_t size = mb << 20;
+    vector<unsigned char> buf(size);
+    mt19937 rng(12345);
+    buf[0] = 'a';
+    for (size_t i = 1; i < size; i++) {
+        buf[i] = TC3_INPUT[rng() % 36];
+    }
+
+    auto time = [&](const char* name, auto run) {
+        auto start = chrono::steady_clock::now();
+        bool ok = run();
+        chrono::duration<double> secs = chrono::steady_clock::now() - start;
+        cout << name << (size / 1e6) / secs.count() << " MB/s ("
+             << (ok ? "accepted" : "rejected") << ")\n";
+    };
+
+    cout << "Input size       : " << mb << " MB\n";
+    time("Runtime table    : ", [&] { return isAccepting(dfa, runDFA(dfa, buf.data(), size)); });
+    time("constexpr table  : ", [&] { return TC3_SPEC.accepting[IdentifierDFA::run(buf.data(), size)]; });
+    time("Switch per state : ", [&] { return TC3_SPEC.accepting[IdentifierDFA::runSwitch(buf.data(), size)]; });
+}
+
+// Byte range [lo, hi] of one state's row that goes to the same target
+struct ByteRange {
+    int lo, hi, target;
+};
+
+// Function to emit the byte dispatch of state st. Each target gets a single
+// branch whose condition ORs its ranges together without branching (or tests
+// a bitmap, written to tables, when it has many ranges); the dead state, or
+// else the target with the most ranges, is the fall-through.
+void emitDispatch(ostream& out, ostream& tables, const string& name, int st,
+                  const vector<ByteRange>& ranges, int dead) {
+    vector<int> targets;
+    map<int, vector<ByteRange>> byTarget;
+    for (const ByteRange& r : ranges) {
+        if (byTarget[r.target].empty()) targets.push_back(r.target);
+        byTarget[r.target].push_back(r);
+    }
+    int fallthrough = byTarget.count(dead) ? dead : targets[0];
+    for (int t : targets) {
+        if (fallthrough != dead && byTarget[t].size() > byTarget[fallthrough].size()) fallthrough = t;
+    }
+
+    for (int t : targets) {
+        if (t == fallthrough) continue;
+        const vector<ByteRange>& rs = byTarget[t];
+        out << "    if (";
+        if (rs.size() <= 4) {
+            for (size_t i = 0; i < rs.size(); i++) {
+                if (i > 0) out << " | ";
+                if (rs[i].lo == rs[i].hi) out << "(c == " << rs[i].lo << ")";
+                else if (rs[i].lo == 0) out << "(c <= " << rs[i].hi << ")";
+                else if (rs[i].hi == 255) out << "(c >= " << rs[i].lo << ")";
+                else out << "(c - " << rs[i].lo << "u < " << rs[i].hi - rs[i].lo + 1 << "u)";
+            }
+        } else {
+            unsigned char bits[32] = {0};
+            for (const ByteRange& r : rs) {
+                for (int b = r.lo; b <= r.hi; b++) bits[b >> 3] |= 1 << (b & 7);
+            }
+            string bitmap = name + "_S" + to_string(st) + "_to_S" + to_string(t);
+            tables << "static const unsigned char " << bitmap << "[32] = {";
+            for (int i = 0; i < 32; i++) {
+                tables << (i % 16 == 0 ? "\n    " : " ") << (int)bits[i] << ",";
+            }
+            tables << "\n};\n";
+            out << "(" << bitmap << "[c >> 3] >> (c & 7)) & 1";
+        }
+        out << ") goto S" << t << ";\n";
+    }
+    if (fallthrough == dead) out << "    return false;\n";
+    else out << "    goto S" << fallthrough << ";\n";
+}
+
+// Function to write a standalone C++ matcher for the automaton: one label
+// per state, range-based byte dispatch and direct gotos between states.
+// Compiling the file with -DDFA_SELFTEST adds a main() that checks the
+// matcher against a table interpreter on random inputs and times both.
+void generateCpp(const CompiledDFA& dfa, ostream& out, const string& name) {
+    const int rows = dfa.no_state + 1;
+    const int dead = dfa.no_state;
+    const int k = dfa.no_col;
+
+    // Bitmaps for wide dispatches go before the function that tests them
+    ostringstream body, tables;
+    body << "// Returns true if the whole buffer is accepted\n";
+    body << "bool " << name << "_match(const unsigned char* s, size_t n) {\n";
+    if (dfa.init == dead) {
+        // No accepting state is reachable: the dead state has no label
+        body << "    (void)s;\n    (void)n;\n    return false;\n";
+    } else {
+        body << "    const unsigned char* end = s + n;\n";
+        body << "    unsigned c;\n";
+        body << "    goto S" << dfa.init << ";\n";
+    }
+
+    for (int st = 0; st < rows; st++) {
+        if (st == dead) continue;
+        vector<ByteRange> ranges;
+        for (int b = 0; b < 256; b++) {
+            int t = dfa.table.get((size_t)st * k + dfa.col[b]);
+            if (!ranges.empty() && ranges.back().target == t) ranges.back().hi = b;
+            else ranges.push_back({b, b, t});
+        }
+        body << "S" << st << ":\n";
+        body << "    if (s == end) return " << (isAccepting(dfa, st) ? "true" : "false") << ";\n";
+        body << "    c = *s++;\n";
+        emitDispatch(body, tables, name, st, ranges, dead);
+    }
+    body << "}\n\n";
+
+    out << "// Generated by prac2 --codegen. Do not edit.\n";
+    out << "// " << rows << " states (dead state included), " << k << " columns.\n";
+    out << "#include <cstddef>\n\n";
+    if (!tables.str().empty()) out << tables.str() << "\n";
+    out << body.str();
+
+    // Self-test: the same automaton as a table, interpreted
+    const char* cell = dfa.table.width() == 1 ? "unsigned char"
+                     : dfa.table.width() == 2 ? "unsigned short" : "unsigned int";
+    out << "#ifdef DFA_SELFTEST\n";
+    out << "#include <chrono>\n#include <cstdio>\n#include <random>\n#include <vector>\n\n";
+    out << "static const int ROWS = " << rows << ", COLS = " << k << ", INIT = " << dfa.init
+        << ", DEAD = " << dead << ";\n";
+    out << "static const unsigned short COL[256] = {";
+    for (int b = 0; b < 256; b++) {
+        out << (b % 16 == 0 ? "\n    " : " ") << dfa.col[b] << ",";
+    }
+    out << "\n};\n";
+    out << "static const " << cell << " TABLE[] = {";
+    for (size_t i = 0; i < dfa.table.size(); i++) {
+        out << (i % 16 == 0 ? "\n    " : " ") << dfa.table.get(i) << ",";
+    }
+    out << "\n};\n";
+    out << "static const bool ACCEPT[] = {";
+    for (int st = 0; st < rows; st++) {
+        out << (st % 16 == 0 ? "\n    " : " ") << (isAccepting(dfa, st) ? 1 : 0) << ",";
+    }
+    out << "\n};\n";
+    out << "static const unsigned char ALPHABET[] = {";
+    for (size_t i = 0; i < dfa.alphabet.size(); i++) {
+        out << (i % 16 == 0 ? "\n    " : " ") << (int)(unsigned char)dfa.alphabet[i] << ",";
+    }
+    out << "\n};\n\n";
+    out << R"(static bool interpret(const unsigned char* s, size_t n) {
+    int st = INIT;
+    for (size_t i = 0; i < n; i++) st = TABLE[(size_t)st * COLS + COL[s[i]]];
+    return ACCEPT[st];
+}
+
+// Random input that mostly uses the alphabet; with live = true, bytes that
+// lead to the dead state are avoided so the matchers run to the end
+static std::vector<unsigned char> randomInput(std::mt19937& rng, size_t n, bool live) {
+    std::vector<unsigned char> s(n);
+    int st = INIT;
+    for (size_t i = 0; i < n; i++) {
+        unsigned char b = 0;
+        for (int tries = 0; tries < 8; tries++) {
+            b = (rng() % 10 || sizeof(ALPHABET) == 0) ? ALPHABET[rng() % sizeof(ALPHABET)] : rng() % 256;
+            if (!live || TABLE[(size_t)st * COLS + COL[b]] != DEAD) break;
+        }
+        s[i] = b;
+        st = TABLE[(size_t)st * COLS + COL[b]];
+    }
+    return s;
+}
+
 int main() {
+    std::mt19937 rng(12345);
+    size_t failures = 0;
+    for (int t = 0; t < 200000; t++) {
+        std::vector<unsigned char> s = randomInput(rng, rng() % 24, rng() % 2);
+)" << "        if (" << name << R"(_match(s.data(), s.size()) != interpret(s.data(), s.size())) failures++;
+    }
+    printf("Random inputs: 200000, mismatches: %zu\n", failures);
+
+    std::vector<unsigned char> big = randomInput(rng, 64 << 20, true);
+    auto time = [&](const char* label, bool (*match)(const unsigned char*, size_t)) {
+        auto start = std::chrono::steady_clock::now();
+        bool ok = match(big.data(), big.size());
+        std::chrono::duration<double> secs = std::chrono::steady_clock::now() - start;
+        printf("%s: %.1f MB/s (%s)\n", label, big.size() / 1e6 / secs.count(), ok ? "accepted" : "rejected");
+    };
+    time("Table interpreter", interpret);
+)" << "    time(\"Generated matcher\", " << name << R"(_match);
+    return failures != 0;
+}
+#endif
+)";
+}
+
+// Function to check a generated function name is a C identifier
+bool validIdentifier(const string& name) {
+    if (name.empty() || (!isalpha((unsigned char)name[0]) && name[0] != '_')) return false;
+    for (char c : name) {
+        if (!isalnum((unsigned char)c) && c != '_') return false;
+    }
+    return true;
+}
+
+bool writeGeneratedCpp(const CompiledDFA& dfa, const char* path, const string& name) {
+    if (!validIdentifier(name)) {
+        cerr << "Invalid function name: " << name << endl;
+        return false;
+    }
+    ofstream out(path);
+    if (!out.is_open()) {
+        cerr << "Cannot write file: " << path << endl;
+        return false;
+    }
+    generateCpp(dfa, out, name);
+    return out.good();
+}
+
+// Function to read strings from the user and validate them
+void menuLoop(const CompiledDFA& dfa) {
+    int ch;
+    do {
+        cout << "\n1. Enter String \n";
+        cout << "2. Exit\n";
+        cout << "3. Throughput benchmark\n";
+        cout << "4. Export compiled DFA\n";
+        cout << "5. Generate C++ matcher\n";
+        cout << "Enter your choice: ";
+        cin >> ch;
+
+        if (ch == 2) break;
+
+        if (ch == 3) {
+            benchmarkDFA(dfa);
+            continue;
+        }
+
+        if (ch == 4) {
+            string path;
+            cout << "Enter output file: ";
+            cin >> path;
+            if (exportDFA(dfa, path.c_str())) {
+                cout << "Compiled DFA written to " << path << "\n";
+            }
+            continue;
+        }
+
+        if (ch == 5) {
+            string path;
+            cout << "Enter output file: ";
+            cin >> path;
+            if (writeGeneratedCpp(dfa, path.c_str(), "dfa")) {
+                cout << "Matcher dfa_match written to " << path << "\n";
+            }
+            continue;
+        }
+
+        if (ch != 1) {
+            cout << "Invalid Choice.\n";
+            continue;
+        }
+
+        cin.ignore();  // Clear input buffer
+        string str;
+        cout << "Enter string: ";
+        getline(cin, str);
+
+        if (acceptsDFA(dfa, str)) {
+            cout << "Valid String\n";
+        } else {
+            cout << "Invalid String\n";
+        }
+
+    } while (true);
+}
+
+void printUsage(const char* prog) {
+    cerr << "Usage: " << prog << "                          (interactive)\n";
+    cerr << "       " << prog << " --batch <dfa-file> [input|-] [--count]\n";
+    cerr << "       " << prog << " --parallel <dfa-file> <input> [threads] [--compare]\n";
+    cerr << "       " << prog << " --export <dfa-file> <compiled-file>\n";
+    cerr << "       " << prog << " --codegen <dfa-file> <out.cpp> [function-prefix]\n";
+    cerr << "       " << prog << " --load <compiled-file> [input|-] [--count]\n";
+    cerr << "       " << prog << " --bench-static [MB]\n";
+    cerr << "       " << prog << " --bench-lanes <dfa-file> <input>\n";
+    cerr << "       " << prog << " --regex <pattern> [input|-] [--count] [--cache-states N] [--engine auto|bits|dfa]\n";
+    cerr << "       " << prog << " --product <any|all|which> <input|-> <dfa-file>... [--count]\n";
+    cerr << "       " << prog << " --check <equal|subset> <dfa-file> <dfa-file>\n";
+    cerr << "       " << prog << " --search <dfa-file> [input|-] [--count]\n";
+    cerr << "       " << prog << " --profile <dfa-file> <training-input> [compiled-file]\n";
+    cerr << "       " << prog << " --bench-threads <dfa-file> <input> [max-threads]\n";
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1) {
+        string mode = argv[1];
+        if (mode == "--batch" && argc >= 3) {
+            CompiledDFA dfa;
+            if (!loadDFA(argv[2], dfa)) return 1;
+            minimizeAndReport(dfa, cerr);
+            const char* path = "-";
+            bool countOnly = false;
+            for (int i = 3; i < argc; i++) {
+                if (strcmp(argv[i], "--count") == 0) countOnly = true;
+                else path = argv[i];
+            }
+            return runBatch(dfa, path, countOnly);
+        }
+        if (mode == "--export" && argc == 4) {
+            CompiledDFA dfa;
+            if (!loadDFA(argv[2], dfa)) return 1;
+            minimizeAndReport(dfa, cerr);
+            return exportDFA(dfa, argv[3]) ? 0 : 1;
+        }
+        if (mode == "--codegen" && (argc == 4 || argc == 5)) {
+            CompiledDFA dfa;
+            if (!loadDFA(argv[2], dfa)) return 1;
+            minimizeAndReport(dfa, cerr);
+            return writeGeneratedCpp(dfa, argv[3], argc == 5 ? argv[4] : "dfa") ? 0 : 1;
+        }
+        if (mode == "--load" && argc >= 3) {
+            MappedDFA dfa;
+            if (!mapDFA(argv[2], dfa)) return 1;
+            const char* path = "-";
+            bool countOnly = false;
+            for (int i = 3; i < argc; i++) {
+                if (strcmp(argv[i], "--count") == 0) countOnly = true;
+                else path = argv[i];
+            }
+            int rc = runBatch(dfa, path, countOnly);
+            unmapDFA(dfa);
+            return rc;
+        }
+        if (mode == "--bench-lanes" && argc == 4) {
+            CompiledDFA dfa;
+            if (!loadDFA(argv[2], dfa)) return 1;
+            minimizeAndReport(dfa, cerr);
+            return benchmarkLanes(dfa, argv[3]);
+        }
+        if (mode == "--regex" && argc >= 3) {
+            const char* path = "-";
+            bool countOnly = false;
+            size_t cacheStates = 4096;
+            string engine = "auto";
+            for (int i = 3; i < argc; i++) {
+                if (strcmp(argv[i], "--count") == 0) countOnly = true;
+                else if (strcmp(argv[i], "--cache-states") == 0 && i + 1 < argc) cacheStates = atol(argv[++i]);
+                else if (strcmp(argv[i], "--engine") == 0 && i + 1 < argc) engine = argv[++i];
+                else path = argv[i];
+            }
+            if (engine != "auto" && engine != "bits" && engine != "dfa") {
+                printUsage(argv[0]);
+                return 1;
+            }
+            try {
+                // Patterns with few positions run bit-parallel with no DFA to
+                // build; larger ones go to the lazy DFA
+                if (engine != "dfa") {
+                    BitNFA bits(argv[2]);
+                    if (bits.ok()) {
+                        int rc = runBatch(bits, path, countOnly);
+                        cerr << "Bit-parallel NFA: " << bits.positions() << " positions, "
+                             << (bits.shiftAnd() ? "Shift-And" : "Glushkov follow tables") << "\n";
+                        return rc;
+                    }
+                    if (engine == "bits") {
+                        cerr << "Pattern needs more than " << BitNFA::MAX_POSITIONS << " positions\n";
+                        return 1;
+                    }
+                }
+                LazyDFA dfa(argv[2], cacheStates);
+                int rc = runBatch(dfa, path, countOnly);
+                cerr << "Lazy DFA: " << dfa.nfaStates() << " NFA states, " << dfa.no_col
+                     << " byte classes, " << dfa.statesBuilt() << " DFA states built, "
+                     << dfa.cacheFlushes() << " cache flushes\n";
+                return rc;
+            } catch (const runtime_error& e) {
+                cerr << e.what() << endl;
+                return 1;
+            }
+        }
+        if (mode == "--product" && argc >= 5) {
+            string op = argv[2];
+            ProductMode pm = op == "any" ? PRODUCT_ANY : op == "all" ? PRODUCT_ALL : PRODUCT_WHICH;
+            if (op != "any" && op != "all" && op != "which") {
+                printUsage(argv[0]);
+                return 1;
+            }
+            bool countOnly = false;
+            vector<CompiledDFA> dfas;
+            for (int i = 4; i < argc; i++) {
+                if (strcmp(argv[i], "--count") == 0) {
+                    countOnly = true;
+                    continue;
+                }
+                dfas.emplace_back();
+                if (!loadDFA(argv[i], dfas.back())) return 1;
+                minimizeAndReport(dfas.back(), cerr);
+            }
+            if (dfas.empty() || dfas.size() > (size_t)MAX_PRODUCT) {
+                cerr << "Between 1 and " << MAX_PRODUCT << " automata are supported\n";
+                return 1;
+            }
+            ProductDFA P = makeProduct(dfas, pm);
+            if (pm == PRODUCT_WHICH) return runWhich(P, argv[3], countOnly);
+            int rc = runBatch(P, argv[3], countOnly);
+            cerr << "Product: " << P.no_col << " byte classes, " << P.states() << " states built\n";
+            return rc;
+        }
+        if (mode == "--search" && argc >= 3) {
+            CompiledDFA dfa;
+            if (!loadDFA(argv[2], dfa)) return 1;
+            minimizeAndReport(dfa, cerr);
+            const char* path = "-";
+            bool countOnly = false;
+            for (int i = 3; i < argc; i++) {
+                if (strcmp(argv[i], "--count") == 0) countOnly = true;
+                else path = argv[i];
+            }
+            return runSearch(dfa, path, countOnly);
+        }
+        if (mode == "--bench-threads" && (argc == 4 || argc == 5)) {
+            CompiledDFA compiled;
+            if (!loadDFA(argv[2], compiled)) return 1;
+            Dfa dfa(move(compiled));
+            int maxThreads = argc == 5 ? atoi(argv[4]) : (int)thread::hardware_concurrency();
+            return benchmarkThreads(dfa, argv[3], max(maxThreads, 1));
+        }
+        if (mode == "--profile" && (argc == 4 || argc == 5)) {
+            CompiledDFA dfa;
+            if (!loadDFA(argv[2], dfa)) return 1;
+            minimizeAndReport(dfa, cerr);
+            return profileAndRenumber(dfa, argv[3], argc == 5 ? argv[4] : NULL);
+        }
+        if (mode == "--check" && argc == 5
+            && (strcmp(argv[2], "equal") == 0 || strcmp(argv[2], "subset") == 0)) {
+            return checkDFAs(argv[2], argv[3], argv[4]);
+        }
+        if (mode == "--bench-static") {
+            benchmarkStatic(argc > 2 ? atoi(argv[2]) : 64);
+            return 0;
+        }
+        if (mode == "--parallel" && argc >= 4) {
+            CompiledDFA dfa;
+            if (!loadDFA(argv[2], dfa)) return 1;
+            minimizeAndReport(dfa, cerr);
+            int threads = thread::hardware_concurrency();
+            bool compare = false;
+            for (int i = 4; i < argc; i++) {
+                if (strcmp(argv[i], "--compare") == 0) compare = true;
+                else threads = atoi(argv[i]);
+            }
+            if (threads <= 0) threads = 1;
+            return runParallel(dfa, argv[3], threads, compare);
+        }
+        printUsage(argv[0]);
+        return 1;
+    }
+
     // ... existing code ...
     cout << "Enter Test CASE Number : ";
     int test;
@@ -10,10 +2633,17 @@ int main() {
 
     if (test != 3) {
         int no_input;
-        cout << "Enter Number of input symbols : ";
-        cin >> no_input;
+        do {
+            cout << "Enter Number of input symbols : ";
+            cin >> no_input;
+            if (no_input > 0 && no_input < 65535) {
+                break;
+            }
+            cout << "Invalid number of input symbols.\n";
+            cout << "Enter Again........\n";
+        } while (true);
 
-        char input[100];  // Using fixed array instead of dynamic
+        vector<char> input(no_input);
         // cout << "Enter Input symbols:\n";
 
         for (int i = 0; i < no_input; i++) {
@@ -21,9 +2651,16 @@ int main() {
             cin >> input[i];
         }
 
-        cout << "\nEnter number of states: ";
         int no_state;
-        cin >> no_state;
+        do {
+            cout << "\nEnter number of states: ";
+            cin >> no_state;
+            if (no_state > 0) {
+                break;
+            }
+            cout << "Invalid number of states.\n";
+            cout << "Enter Again........\n";
+        } while (true);
 
         // Check Valid initial State
         int init;
@@ -41,8 +2678,9 @@ int main() {
         cout << "Enter number of accepting states: ";
         int no_accept;
         cin >> no_accept;
+        if (no_accept < 0) no_accept = 0;
 
-        int accept[100];  // Using fixed array
+        vector<int> accept(no_accept);
         for (int i = 0; i < no_accept; i++) {
             do {
                 cout << "Enter accepting state " << (i + 1) << ": ";
@@ -56,15 +2694,16 @@ int main() {
         }
 
         // Transition Table
-        int TT[100][100];  // Using fixed size 2D array
+        vector<int> TT((size_t)no_state * no_input);  // row-major, no_input per row
         cout << "Enter Transition Table:\n";
 
         for (int i = 0; i < no_state; i++) {
             for (int j = 0; j < no_input; j++) {
+                int& cell = TT[(size_t)i * no_input + j];
                 do {
                     cout << "State " << (i + 1) << " to " << input[j] << ": ";
-                    cin >> TT[i][j];
-                    if(TT[i][j] > 0 && TT[i][j] <= no_state) {
+                    cin >> cell;
+                    if(cell > 0 && cell <= no_state) {
                         break;
                     }
                     cout << "Invalid State\n";
@@ -74,138 +2713,18 @@ int main() {
             cout << endl;
         }
 
-        // Adding dead state transitions
-        for (int j = 0; j < no_input; j++) {
-            TT[no_state][j] = no_state + 1;
-        }
-
-        int ch;
-        do {
-            cout << "\n1. Enter String \n";
-            cout << "2. Exit\n";
-            cout << "Enter your choice: ";
-            cin >> ch;
-
-            if (ch == 2) break;
-
-            if (ch != 1) {
-                cout << "Invalid Choice.\n";
-                continue;
-            }
-
-            cin.ignore();  // Clear input buffer
-            string str;
-            cout << "Enter string: ";
-            getline(cin, str);
-
-            int current = init;
-
-            for (int i = 0; i < str.length(); i++) {
-                bool found = false;
-                for (int j = 0; j < no_input; j++) {
-                    if (str[i] == input[j]) {
-                        current = TT[current - 1][j];
-                        found = true;
-                        break;
-                    }
-                }
-                if (!found) {
-                    current = no_state;
-                    break;
-                }
-            }
-
-            bool valid = false;
-            if (current != no_state + 1) {
-                for (int i = 0; i < no_accept; i++) {
-                    if (accept[i] == current) {
-                        valid = true;
-                        break;
-                    }
-                }
-            }
-
-            // cout << current << endl;
-            if (valid) {
-                cout << "Valid String\n";
-            } else {
-                cout << "Invalid String\n";
-            }
-
-        } while (true);
+        // Dead state and reject column are added by the compiler
+        CompiledDFA dfa = compileDFA(input.data(), no_input, no_state, init,
+                                     accept.data(), no_accept, TT.data(), no_input);
+        minimizeAndReport(dfa, cout);
+        menuLoop(dfa);
 
     } else {
         // Test case 3 implementation
-        int init = 1;
-        int no_input = 36;
-        char input[] = {'a', 'b', 'c', 'd', 'e', 'f', 'g', 'h', 'i', 'j', 'k', 'l', 'm', 
-                        'n', 'o', 'p', 'q', 'r', 's', 't', 'u', 'v', 'w', 'x', 'y', 'z',
-                        '0', '1', '2', '3', '4', '5', '6', '7', '8', '9'};
-        int no_state = 3;
-        int no_accept = 1;
-        int accept[] = {2};
-
-        // Transition Table
-        int TT[4][36] = {
-            {2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,3,3,3,3,3,3,3,3,3,3},
-            {2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2},
-            {3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3},
-            {3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3}
-        };
-
-        int ch;
-        do {
-            cout << "\n1. Enter String \n";
-            cout << "2. Exit\n";
-            cout << "Enter your choice: ";
-            cin >> ch;
-
-            if (ch == 2) break;
-
-            if (ch != 1) {
-                cout << "Invalid Choice.\n";
-                continue;
-            }
-
-            cin.ignore();
-            string str;
-            cout << "Enter string: ";
-            getline(cin, str);
-
-            int current = init;
-
-            for (int i = 0; i < str.length(); i++) {
-                bool found = false;
-                for (int j = 0; j < no_input; j++) {
-                    if (str[i] == input[j]) {
-                        current = TT[current - 1][j];
-                        found = true;
-                        break;
-                    }
-                }
-                if (!found) {
-                    current = no_state;
-                    break;
-                }
-            }
-
-            bool valid = false;
-            if (current != no_state + 1) {
-                for (int i = 0; i < no_accept; i++) {
-                    if (accept[i] == current) {
-                        valid = true;
-                        break;
-                    }
-                }
-            }
-
-            if (valid) {
-                cout << "Valid String\n";
-            } else {
-                cout << "Invalid String\n";
-            }
-
-        } while (true);
+        CompiledDFA dfa = compileDFA(TC3_INPUT, 36, TC3_STATES, TC3_INIT,
+                                     TC3_ACCEPT, 1, &TC3_TT[0][0], 36);
+        minimizeAndReport(dfa, cout);
+        menuLoop(dfa);
     }
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,507 @@
+#ifndef REGEX_DFA_H
+#define REGEX_DFA_H
+
+#include <algorithm>
+#include <bitset>
+#include <cctype>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Regular expression front end for the DFA simulator: a pattern is parsed
+// into a syntax tree, compiled to a Thompson NFA, and DFA states are built on
+// demand while matching (lazy subset construction) inside a bounded cache.
+// Matching is anchored at both ends, like the table-driven acceptor.
+//
+// Supported syntax: literals, '.', [...] and [^...] classes with ranges,
+// \d \w \s \D \W \S and escaped metacharacters, grouping, '|', '*', '+', '?'
+// and {m}, {m,}, {m,n} repetition.
+
+using ByteSet = std::bitset<256>;
+
+struct RegexNode {
+    enum Type { EMPTY, BYTES, CONCAT, ALT, REPEAT };
+    Type type;
+    ByteSet set;                                   // BYTES
+    std::vector<std::unique_ptr<RegexNode>> kids;  // CONCAT, ALT, REPEAT (one kid)
+    int min = 0, max = -1;                         // REPEAT, max -1 = unbounded
+};
+
+inline int firstByte(const ByteSet& set) {
+    for (int b = 0; b < 256; b++) {
+        if (set[b]) return b;
+    }
+    return -1;
+}
+
+class RegexParser {
+public:
+    explicit RegexParser(const std::string& pattern) : re(pattern) {}
+
+    // Function to parse the whole pattern; throws std::runtime_error on bad
+    // syntax, on nesting deeper than MAX_DEPTH or when the pattern would
+    // compile to more than MAX_NFA_STATES
+    std::unique_ptr<RegexNode> parse() {
+        std::unique_ptr<RegexNode> node = parseAlt();
+        if (pos != re.size()) fail("unexpected ')'");
+        if (compiledSize(*node) > MAX_NFA_STATES) throw std::runtime_error("pattern too large");
+        return node;
+    }
+
+    // Limit on the Thompson NFA a pattern expands to. Counts bound each
+    // repeat on its own, but nested repeats multiply, so the total is checked.
+    static const size_t MAX_NFA_STATES = 1 << 20;
+
+    // Limit on groups and repeats nested in one another. The parser, the
+    // size count, both compilers and the tree's destructor recurse once per
+    // level, so deeper patterns would overflow the stack.
+    static const int MAX_DEPTH = 1000;
+
+private:
+    static const int MAX_REPEAT = 1000;
+    const std::string& re;
+    size_t pos = 0;
+    int depth = 0;      // groups open at pos
+    int height = 0;     // nesting of the node parsed last
+
+    [[noreturn]] void fail(const std::string& msg) {
+        throw std::runtime_error("regex error at offset " + std::to_string(pos) + ": " + msg);
+    }
+
+    bool more() const { return pos < re.size(); }
+
+    static std::unique_ptr<RegexNode> make(RegexNode::Type type) {
+        std::unique_ptr<RegexNode> node(new RegexNode);
+        node->type = type;
+        return node;
+    }
+
+    // Function to count the NFA states ThompsonNFA::compile makes for node,
+    // stopping at just past MAX_NFA_STATES so the products cannot overflow
+    static size_t compiledSize(const RegexNode& node) {
+        size_t size = 0;
+        switch (node.type) {
+        case RegexNode::EMPTY:
+            break;
+        case RegexNode::BYTES:
+            size = 1;
+            break;
+        case RegexNode::CONCAT:
+        case RegexNode::ALT:
+            for (const auto& kid : node.kids) {
+                size += compiledSize(*kid);
+                if (size > MAX_NFA_STATES) break;
+            }
+            if (node.type == RegexNode::ALT) size += node.kids.size() - 1;
+            break;
+        case RegexNode::REPEAT: {
+            size_t kid = compiledSize(*node.kids[0]);
+            if (node.max < 0) size = kid * std::max(node.min, 1) + 1;
+            else size = kid * node.max + (node.max - node.min);
+            break;
+        }
+        }
+        return std::min(size, MAX_NFA_STATES + 1);
+    }
+
+    std::unique_ptr<RegexNode> parseAlt() {
+        std::unique_ptr<RegexNode> first = parseConcat();
+        if (!more() || re[pos] != '|') return first;
+        std::unique_ptr<RegexNode> alt = make(RegexNode::ALT);
+        alt->kids.push_back(std::move(first));
+        int h = height;
+        while (more() && re[pos] == '|') {
+            pos++;
+            alt->kids.push_back(parseConcat());
+            h = std::max(h, height);
+        }
+        height = h;
+        return alt;
+    }
+
+    std::unique_ptr<RegexNode> parseConcat() {
+        std::unique_ptr<RegexNode> cat = make(RegexNode::CONCAT);
+        int h = 0;
+        while (more() && re[pos] != '|' && re[pos] != ')') {
+            cat->kids.push_back(parseRepeat());
+            h = std::max(h, height);
+        }
+        height = h;
+        if (cat->kids.empty()) return make(RegexNode::EMPTY);
+        if (cat->kids.size() == 1) return std::move(cat->kids[0]);
+        return cat;
+    }
+
+    int parseCount() {
+        if (!more() || !isdigit((unsigned char)re[pos])) fail("expected repetition count");
+        int n = 0;
+        while (more() && isdigit((unsigned char)re[pos])) {
+            n = n * 10 + (re[pos++] - '0');
+            if (n > MAX_REPEAT) fail("repetition count too large");
+        }
+        return n;
+    }
+
+    std::unique_ptr<RegexNode> parseRepeat() {
+        std::unique_ptr<RegexNode> atom = parseAtom();
+        while (more()) {
+            int lo, hi;
+            char c = re[pos];
+            if (c == '*') { lo = 0; hi = -1; pos++; }
+            else if (c == '+') { lo = 1; hi = -1; pos++; }
+            else if (c == '?') { lo = 0; hi = 1; pos++; }
+            else if (c == '{') {
+                pos++;
+                lo = hi = parseCount();
+                if (more() && re[pos] == ',') {
+                    pos++;
+                    hi = (more() && re[pos] == '}') ? -1 : parseCount();
+                }
+                if (!more() || re[pos] != '}') fail("expected '}'");
+                pos++;
+                if (hi >= 0 && hi < lo) fail("bad repetition range");
+            }
+            else break;
+
+            if (++height > MAX_DEPTH) fail("pattern nested too deeply");
+            std::unique_ptr<RegexNode> rep = make(RegexNode::REPEAT);
+            rep->min = lo;
+            rep->max = hi;
+            rep->kids.push_back(std::move(atom));
+            atom = std::move(rep);
+        }
+        return atom;
+    }
+
+    ByteSet parseEscape() {
+        if (!more()) fail("trailing backslash");
+        char c = re[pos++];
+        ByteSet set;
+        switch (c) {
+        case 'd': case 'D':
+            for (int b = '0'; b <= '9'; b++) set.set(b);
+            break;
+        case 'w': case 'W':
+            for (int b = 0; b < 256; b++) if (isalnum(b) || b == '_') set.set(b);
+            break;
+        case 's': case 'S':
+            for (const char* p = " \t\n\r\f\v"; *p; p++) set.set((unsigned char)*p);
+            break;
+        case 'n': set.set('\n'); return set;
+        case 't': set.set('\t'); return set;
+        case 'r': set.set('\r'); return set;
+        default:
+            set.set((unsigned char)c);
+            return set;
+        }
+        if (isupper((unsigned char)c)) set.flip();
+        return set;
+    }
+
+    ByteSet parseClass() {
+        bool negate = more() && re[pos] == '^';
+        if (negate) pos++;
+        ByteSet set;
+        bool first = true;
+        while (more() && (re[pos] != ']' || first)) {
+            first = false;
+            ByteSet item;
+            int lo;
+            if (re[pos] == '\\') {
+                pos++;
+                item = parseEscape();
+                if (item.count() != 1) {
+                    set |= item;
+                    continue;
+                }
+                lo = firstByte(item);
+            } else {
+                lo = (unsigned char)re[pos++];
+            }
+            int hi = lo;
+            if (pos + 1 < re.size() && re[pos] == '-' && re[pos + 1] != ']') {
+                pos++;
+                if (re[pos] == '\\') {
+                    pos++;
+                    ByteSet end = parseEscape();
+                    if (end.count() != 1) fail("bad class range");
+                    hi = firstByte(end);
+                } else {
+                    hi = (unsigned char)re[pos++];
+                }
+                if (hi < lo) fail("bad class range");
+            }
+            for (int b = lo; b <= hi; b++) set.set(b);
+        }
+        if (!more()) fail("missing ']'");
+        pos++;
+        if (negate) set.flip();
+        return set;
+    }
+
+    std::unique_ptr<RegexNode> parseAtom() {
+        char c = re[pos++];
+        if (c == '(') {
+            if (++depth > MAX_DEPTH) fail("pattern nested too deeply");
+            std::unique_ptr<RegexNode> inner = parseAlt();
+            if (!more() || re[pos] != ')') fail("missing ')'");
+            pos++;
+            depth--;
+            if (++height > MAX_DEPTH) fail("pattern nested too deeply");
+            return inner;
+        }
+        if (c == '*' || c == '+' || c == '?' || c == '{') fail("nothing to repeat");
+
+        height = 0;
+        std::unique_ptr<RegexNode> node = make(RegexNode::BYTES);
+        if (c == '.') node->set.set().reset('\n');
+        else if (c == '[') node->set = parseClass();
+        else if (c == '\\') node->set = parseEscape();
+        else node->set.set((unsigned char)c);
+        return node;
+    }
+};
+
+// Thompson NFA. BYTES states consume one byte from their set and go to out;
+// SPLIT states branch to out and out1 without consuming; MATCH accepts.
+struct ThompsonNFA {
+    enum Type { BYTES, SPLIT, MATCH };
+    struct State {
+        Type type;
+        int set;      // index into sets for BYTES
+        int out, out1;
+    };
+    std::vector<State> states;
+    std::vector<ByteSet> sets;
+    int start;
+
+    int add(Type type, int set, int out, int out1) {
+        states.push_back({type, set, out, out1});
+        return states.size() - 1;
+    }
+
+    // Function to compile node so that it continues to state out (built
+    // back to front, so no patch lists are needed)
+    int compile(const RegexNode& node, int out) {
+        switch (node.type) {
+        case RegexNode::EMPTY:
+            return out;
+        case RegexNode::BYTES:
+            sets.push_back(node.set);
+            return add(BYTES, sets.size() - 1, out, -1);
+        case RegexNode::CONCAT:
+            for (size_t i = node.kids.size(); i-- > 0;) {
+                out = compile(*node.kids[i], out);
+            }
+            return out;
+        case RegexNode::ALT: {
+            int entry = compile(*node.kids.back(), out);
+            for (size_t i = node.kids.size() - 1; i-- > 0;) {
+                entry = add(SPLIT, -1, compile(*node.kids[i], out), entry);
+            }
+            return entry;
+        }
+        case RegexNode::REPEAT: {
+            const RegexNode& kid = *node.kids[0];
+            if (node.max < 0) {
+                // x{m,}: m - 1 copies then x+ (or x* when m == 0)
+                int loop = add(SPLIT, -1, -1, out);
+                int body = compile(kid, loop);
+                states[loop].out = body;
+                int entry = node.min == 0 ? loop : body;
+                for (int i = 1; i < node.min; i++) {
+                    entry = compile(kid, entry);
+                }
+                return entry;
+            }
+            // x{m,n}: n - m nested optional copies, then m required copies
+            int entry = out;
+            for (int i = node.min; i < node.max; i++) {
+                entry = add(SPLIT, -1, compile(kid, entry), out);
+            }
+            for (int i = 0; i < node.min; i++) {
+                entry = compile(kid, entry);
+            }
+            return entry;
+        }
+        }
+        return out;
+    }
+
+    explicit ThompsonNFA(const RegexNode& root) {
+        int match = add(MATCH, -1, -1, -1);
+        start = compile(root, match);
+    }
+};
+
+// Lazily built DFA over a Thompson NFA. Each DFA state is the sorted set of
+// BYTES/MATCH NFA states reached after an epsilon closure. Rows are indexed
+// by byte class and start as unknown (-1); a miss builds the successor. When
+// the cache holds maxStates states it is flushed and refilled on demand, so
+// memory stays bounded however large the full DFA would be. The cache is
+// mutable state: one LazyDFA must not be matched from several threads.
+class LazyDFA {
+public:
+    static const int DEAD = 1;   // the empty NFA set; init is always slot 0
+
+    int init = 0;
+    int no_col;
+    int col[256];
+
+    LazyDFA(const std::string& pattern, size_t maxStates)
+        : root(RegexParser(pattern).parse()), nfa(*root), maxStates(maxStates < 3 ? 3 : maxStates) {
+        computeClasses();
+        mark.assign(nfa.states.size(), 0);
+        std::vector<int> start;
+        closure({nfa.start}, start);
+        startSet = start;
+        reset();
+    }
+
+    int step(int current, const unsigned char* s, size_t n) const {
+        const int* T = next.data();
+        for (size_t i = 0; i < n; i++) {
+            int c = col[s[i]];
+            int nx = T[current * no_col + c];
+            if (nx < 0) {
+                nx = build(current, c);
+                T = next.data();
+            }
+            current = nx;
+            if (current == DEAD) break;   // no NFA thread is left alive
+        }
+        return current;
+    }
+
+    bool accepting(int state) const { return match[state]; }
+
+    size_t statesBuilt() const { return built; }
+    size_t cacheFlushes() const { return flushes; }
+    size_t cachedStates() const { return sets.size(); }
+    size_t nfaStates() const { return nfa.states.size(); }
+
+private:
+    std::unique_ptr<RegexNode> root;
+    ThompsonNFA nfa;
+    size_t maxStates;
+    int classRep[256];
+    std::vector<int> startSet;
+
+    mutable std::vector<int> next;
+    mutable std::vector<char> match;
+    mutable std::vector<std::vector<int>> sets;
+    mutable std::unordered_map<std::string, int> index;
+    mutable std::vector<unsigned> mark;
+    mutable unsigned generation = 0;
+    mutable size_t built = 0, flushes = 0;
+
+    // Bytes that every character set treats alike share one column
+    void computeClasses() {
+        for (int b = 0; b < 256; b++) col[b] = 0;
+        no_col = 1;
+        for (const ByteSet& set : nfa.sets) {
+            int remap[2][256];
+            memset(remap, -1, sizeof(remap));
+            int n = 0;
+            for (int b = 0; b < 256; b++) {
+                int& id = remap[set[b]][col[b]];
+                if (id < 0) id = n++;
+                col[b] = id;
+            }
+            no_col = n;
+        }
+        for (int b = 255; b >= 0; b--) classRep[col[b]] = b;
+    }
+
+    void closure(const std::vector<int>& seeds, std::vector<int>& out) const {
+        if (++generation == 0) {
+            std::fill(mark.begin(), mark.end(), 0);
+            generation = 1;
+        }
+        std::vector<int> stack(seeds.rbegin(), seeds.rend());
+        out.clear();
+        while (!stack.empty()) {
+            int s = stack.back();
+            stack.pop_back();
+            if (mark[s] == generation) continue;
+            mark[s] = generation;
+            const ThompsonNFA::State& st = nfa.states[s];
+            if (st.type == ThompsonNFA::SPLIT) {
+                stack.push_back(st.out1);
+                stack.push_back(st.out);
+            } else {
+                out.push_back(s);
+            }
+        }
+        std::sort(out.begin(), out.end());
+    }
+
+    int intern(const std::vector<int>& set) const {
+        std::string key((const char*)set.data(), set.size() * sizeof(int));
+        auto it = index.find(key);
+        if (it != index.end()) return it->second;
+
+        int id = sets.size();
+        index.emplace(std::move(key), id);
+        sets.push_back(set);
+        bool isMatch = false;
+        for (int s : set) {
+            if (nfa.states[s].type == ThompsonNFA::MATCH) isMatch = true;
+        }
+        match.push_back(isMatch);
+        next.resize(next.size() + no_col, -1);
+        built++;
+        return id;
+    }
+
+    void reset() const {
+        sets.clear();
+        index.clear();
+        match.clear();
+        next.clear();
+        intern(startSet);               // slot 0
+        intern(std::vector<int>());     // slot 1 = DEAD
+        for (int c = 0; c < no_col; c++) next[DEAD * no_col + c] = DEAD;
+    }
+
+    int build(int current, int c) const {
+        std::vector<int> seeds, target;
+        int b = classRep[c];
+        for (int s : sets[current]) {
+            const ThompsonNFA::State& st = nfa.states[s];
+            if (st.type == ThompsonNFA::BYTES && nfa.sets[st.set][b]) {
+                seeds.push_back(st.out);
+            }
+        }
+        closure(seeds, target);
+
+        auto it = index.find(std::string((const char*)target.data(), target.size() * sizeof(int)));
+        if (it != index.end()) {
+            next[current * no_col + c] = it->second;
+            return it->second;
+        }
+        if (sets.size() >= maxStates) {
+            // Cache full: drop every state; the caller only holds the new one
+            flushes++;
+            reset();
+            return intern(target);
+        }
+        int id = intern(target);
+        next[current * no_col + c] = id;
+        return id;
+    }
+};
+
+inline int stepDFA(const LazyDFA& dfa, int current, const unsigned char* s, size_t n) {
+    return dfa.step(current, s, n);
+}
+
+inline bool isAccepting(const LazyDFA& dfa, int state) {
+    return dfa.accepting(state);
+}
+
+#endif
@@ -0,0 +1,140 @@
+#ifndef STATIC_DFA_H
+#define STATIC_DFA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+// Automaton fixed at compile time. States are 0-based and the last state is
+// the dead state; bytes outside the alphabet map to the last (reject) column.
+template <int States, int Cols>
+struct StaticSpec {
+    using Cell = std::conditional_t<States <= 256, uint8_t,
+                 std::conditional_t<States <= 65536, uint16_t, uint32_t>>;
+
+    int init;
+    uint8_t col[256];
+    Cell next[States][Cols];
+    bool accepting[States];
+};
+
+// Function to build a spec from the same data the interactive program takes:
+// the alphabet, a 1-based transition table (extra rows are ignored), the
+// 1-based initial state and the 1-based accepting states
+template <int UserStates, size_t Syms, size_t Rows, size_t Accepts>
+constexpr StaticSpec<UserStates + 1, Syms + 1>
+makeStaticSpec(const char (&input)[Syms], const int (&TT)[Rows][Syms], int init,
+               const int (&accept)[Accepts]) {
+    static_assert(UserStates <= (int)Rows, "transition table has too few rows");
+    static_assert(Syms <= 255, "alphabet too large for a byte column map");
+
+    StaticSpec<UserStates + 1, Syms + 1> spec{};
+    const int dead = UserStates;
+    spec.init = init - 1;
+
+    for (int b = 0; b < 256; b++) {
+        spec.col[b] = Syms;
+    }
+    for (int j = Syms - 1; j >= 0; j--) {
+        spec.col[(unsigned char)input[j]] = j;
+    }
+
+    for (int i = 0; i <= UserStates; i++) {
+        for (size_t j = 0; j <= Syms; j++) {
+            bool user = i < UserStates && j < Syms;
+            spec.next[i][j] = user ? TT[i][j] - 1 : dead;
+        }
+        spec.accepting[i] = false;
+    }
+    for (size_t i = 0; i < Accepts; i++) {
+        spec.accepting[accept[i] - 1] = true;
+    }
+    return spec;
+}
+
+template <int States, int Cols>
+constexpr bool sameColumn(const StaticSpec<States, Cols>& spec, int a, int b) {
+    for (int s = 0; s < States; s++) {
+        if (spec.next[s][a] != spec.next[s][b]) return false;
+    }
+    return true;
+}
+
+// Function to count the byte classes of a spec: columns some byte maps to,
+// with columns that agree in every state counted once
+template <int States, int Cols>
+constexpr int countByteClasses(const StaticSpec<States, Cols>& spec) {
+    int rep[Cols] = {};
+    int classes = 0;
+    for (int b = 0; b < 256; b++) {
+        int i = 0;
+        while (i < classes && !sameColumn(spec, rep[i], spec.col[b])) i++;
+        if (i == classes) rep[classes++] = spec.col[b];
+    }
+    return classes;
+}
+
+// Function to rebuild a spec with one column per byte class, numbered in
+// byte order as compressColumns does for the runtime table
+template <int Classes, int States, int Cols>
+constexpr StaticSpec<States, Classes> compressByteClasses(const StaticSpec<States, Cols>& spec) {
+    StaticSpec<States, Classes> out{};
+    out.init = spec.init;
+    int rep[Classes] = {};
+    int classes = 0;
+    for (int b = 0; b < 256; b++) {
+        int i = 0;
+        while (i < classes && !sameColumn(spec, rep[i], spec.col[b])) i++;
+        if (i == classes) rep[classes++] = spec.col[b];
+        out.col[b] = i;
+    }
+    for (int s = 0; s < States; s++) {
+        for (int j = 0; j < Classes; j++) {
+            out.next[s][j] = spec.next[s][rep[j]];
+        }
+        out.accepting[s] = spec.accepting[s];
+    }
+    return out;
+}
+
+// Matcher specialised on a constexpr spec: the table and byte map are
+// constants, so the loop needs no pointer loads and keeps state in a register
+template <const auto& Spec>
+struct StaticDFA {
+    static int run(const unsigned char* s, size_t n) {
+        int state = Spec.init;
+        for (size_t i = 0; i < n; i++) {
+            state = Spec.next[state][Spec.col[s[i]]];
+        }
+        return state;
+    }
+
+    // Same automaton with one branch per state, each reading only its own
+    // row, so the compiler can lower it to a switch over constant rows
+    static int runSwitch(const unsigned char* s, size_t n) {
+        int state = Spec.init;
+        for (size_t i = 0; i < n; i++) {
+            state = stepState<0>(state, Spec.col[s[i]]);
+        }
+        return state;
+    }
+
+    static bool accepts(const unsigned char* s, size_t n) {
+        return Spec.accepting[run(s, n)];
+    }
+
+private:
+    static constexpr int STATES = sizeof(Spec.accepting) / sizeof(Spec.accepting[0]);
+
+    template <int S>
+    static int stepState(int state, int c) {
+        if constexpr (S + 1 == STATES) {
+            return Spec.next[S][c];
+        } else {
+            if (state == S) return Spec.next[S][c];
+            return stepState<S + 1>(state, c);
+        }
+    }
+};
+
+#endif
@@ -6,42 +6,171 @@
 #include <map>
 #include <sstream>
 #include <iomanip>
+#include <string_view>
+#include <cstdint>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <unordered_map>
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 using namespace std;
 
-// Global sets and maps
-set<string> keywords = {
+// Fixed token lists, looked up through perfect hashes built at compile time
+constexpr string_view KEYWORDS[] = {
     "auto", "break", "case", "char", "const", "continue", "default", "do",
     "double", "else", "enum", "extern", "float", "for", "goto", "if",
     "int", "long", "register", "return", "short", "signed", "sizeof", "static",
     "struct", "switch", "typedef", "union", "unsigned", "void", "volatile", "while"
 };
 
-set<string> ops = {
+constexpr string_view OPS[] = {
     "+", "-", "*", "/", "%", "=", "==", "!=", "<", ">", "<=", ">=", "&&", "||",
     "!", "&", "|", "^", "~", "<<", ">>", "+=", "-=", "*=", "/=", "%="
 };
 
-set<string> puncs = {"(", ")", "{", "}", "[", "]", ";", ","};
+constexpr string_view PUNCS[] = {"(", ")", "{", "}", "[", "]", ";", ","};
+
+// Set of N fixed words with a collision-free hash into Size slots (Size a
+// power of two). The key packs the first byte, last byte and length; a
+// multiplier that spreads the keys of all N words to distinct slots is found
+// at compile time. Membership is one multiply, one slot load and at most one
+// string compare.
+template <size_t N, size_t Size>
+struct PerfectSet {
+    string_view words[N] = {};
+    uint8_t slot[Size] = {};   // word index + 1, 0 = empty
+    uint32_t mul = 0;
+    bool ok = false;
+
+    static constexpr int bits() {
+        int b = 0;
+        while (((size_t)1 << b) < Size) b++;
+        return b;
+    }
+
+    constexpr size_t hash(string_view s) const {
+        uint32_t key = (unsigned char)s[0] | (unsigned char)s[s.size() - 1] << 8 | (uint32_t)s.size() << 16;
+        return (uint32_t)(key * mul) >> (32 - bits());
+    }
+
+    constexpr bool contains(string_view s) const {
+        if (s.empty()) return false;
+        int i = slot[hash(s)];
+        return i != 0 && words[i - 1] == s;
+    }
+};
 
-map<string, int> symTable;
+// Function to search for a multiplier that gives the words distinct slots
+template <size_t Size, size_t N>
+constexpr PerfectSet<N, Size> makePerfectSet(const string_view (&words)[N]) {
+    PerfectSet<N, Size> set;
+    for (size_t i = 0; i < N; i++) set.words[i] = words[i];
+    for (uint32_t t = 1; t < 100000 && !set.ok; t++) {
+        set.mul = (t * 2654435761u) | 1;
+        bool used[Size] = {};
+        set.ok = true;
+        for (size_t i = 0; i < N && set.ok; i++) {
+            size_t h = set.hash(words[i]);
+            set.ok = !used[h];
+            used[h] = true;
+        }
+    }
+    for (size_t i = 0; i < N; i++) set.slot[set.hash(words[i])] = i + 1;
+    return set;
+}
+
+constexpr auto keywords = makePerfectSet<128>(KEYWORDS);
+constexpr auto ops = makePerfectSet<64>(OPS);
+constexpr auto puncs = makePerfectSet<16>(PUNCS);
+static_assert(keywords.ok && ops.ok && puncs.ok, "no perfect hash found; grow the table");
+
+// Class of a byte when it starts a token; lexing and classification branch
+// on it before trying any table
+enum CharClass : uint8_t { C_OTHER, C_SPACE, C_IDENT, C_DIGIT, C_DOT, C_QUOTE, C_DQUOTE, C_OP, C_PUNCT };
+
+struct CharClasses {
+    CharClass of[256];
+};
+
+constexpr CharClasses makeCharClasses() {
+    CharClasses t{};
+    for (int c = 0; c < 256; c++) {
+        bool alpha = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+        t.of[c] = alpha ? C_IDENT : c >= '0' && c <= '9' ? C_DIGIT : C_OTHER;
+    }
+    for (char c : {' ', '\t', '\n', '\v', '\f', '\r'}) t.of[(unsigned char)c] = C_SPACE;
+    t.of['.'] = C_DOT;
+    t.of['\''] = C_QUOTE;
+    t.of['\"'] = C_DQUOTE;
+    // Every two-character operator starts with a one-character one
+    for (string_view w : OPS) {
+        if (w.size() == 1) t.of[(unsigned char)w[0]] = C_OP;
+    }
+    for (string_view w : PUNCS) t.of[(unsigned char)w[0]] = C_PUNCT;
+    return t;
+}
+
+constexpr CharClasses charClass = makeCharClasses();
+
+enum TokenKind {
+    KEYWORD, OPERATOR, PUNCTUATION, NUMBER, CHAR_CONST, STRING_CONST, IDENTIFIER, COMMENT, INVALID
+};
+
+// A token is a slice of the mapped source; its text is never copied
+struct Token {
+    size_t offset;
+    uint32_t length;
+    uint32_t line;
+    TokenKind kind;
+};
+
+// Where the lexer is between two bytes of the source
+enum LexState { CODE, IN_STRING, IN_CHAR, LINE_COMMENT, BLOCK_COMMENT };
+
+// A piece of the source ending after a newline (or at the end of the file),
+// lexed on its own with lines counted from 1. When the chunk before it ends
+// inside a comment or literal, its first token continues that chunk's last
+// one and is merged into it (skip = 1).
+struct LexChunk {
+    size_t begin, end;
+    LexState entry = CODE, exit = CODE;
+    int lines = 0;                  // newlines in [begin, end)
+    size_t skip = 0;
+    vector<Token> toks;
+    unordered_map<string_view, int> symbols;    // identifier -> last line
+    map<int, vector<string>> errors;
+};
+
+map<string, int, less<>> symTable;
 map<int, vector<string>> errList;
 
 // Function declarations
-bool isChar(const string& tok);
-bool isStr(const string& tok);
-bool isNum(const string& tok);
-bool isIdentifier(const string& tok);
-vector<string> tokenize(const string& line);
-void processLine(const string& line, int line_no);
+bool isChar(string_view tok);
+bool isStr(string_view tok);
+bool isNum(string_view tok);
+bool isIdentifier(string_view tok);
+TokenKind classify(string_view tok);
+LexState lex(string_view src, size_t begin, size_t end, LexState state, int& line_no,
+             vector<Token>& toks);
+vector<LexChunk> lexSource(string_view src, int threads);
+void report(string_view src, const vector<LexChunk>& chunks);
 void addErr(int line_no, const string& err);
 void printSymbolTable();
 void printErrors();
 
-bool isChar(const string& tok) {
+bool isChar(string_view tok) {
     return tok.length() >= 3 && tok[0] == '\'' && tok[tok.length()-1] == '\'';
 }
 
-bool isStr(const string& tok) {
+bool isStr(string_view tok) {
     return tok.length() >= 2 && tok[0] == '\"' && tok[tok.length()-1] == '\"';
 }
 
@@ -49,25 +178,70 @@ void addErr(int line_no, const string& err) {
     errList[line_no].push_back(err);
 }
 
-bool isNum(const string& tok) {
-    try {
-        // Handle floating point
-        if (tok.find('.') != string::npos) {
-            size_t pos;
-            stod(tok, &pos);
-            return pos == tok.length();
+// Function to recognise a C integer constant (decimal, octal or hex, with
+// u/l/ll suffixes) or floating constant (decimal or hex, with an f/l suffix)
+bool isNum(string_view tok) {
+    size_t i = 0, n = tok.size();
+    bool hex = n > 2 && tok[0] == '0' && (tok[1] == 'x' || tok[1] == 'X');
+    auto isDigit = [&](char c) {
+        return (c >= '0' && c <= '9') || (hex && ((c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F')));
+    };
+    if (hex) i = 2;
+
+    size_t start = i;
+    while (i < n && isDigit(tok[i])) i++;
+    size_t whole = i - start;
+    bool isFloat = false;
+    if (i < n && tok[i] == '.') {
+        isFloat = true;
+        i++;
+    }
+    size_t fracStart = i;
+    while (isFloat && i < n && isDigit(tok[i])) i++;
+    if (whole + (i - fracStart) == 0) return false;
+
+    char e = hex ? 'p' : 'e';
+    if (i < n && (tok[i] == e || tok[i] == e - 'a' + 'A')) {
+        i++;
+        if (i < n && (tok[i] == '+' || tok[i] == '-')) i++;
+        size_t expStart = i;
+        while (i < n && tok[i] >= '0' && tok[i] <= '9') i++;
+        if (i == expStart) return false;
+        isFloat = true;
+    }
+    else if (hex && isFloat) {
+        return false;   // a hex fraction needs a binary exponent
+    }
+
+    if (isFloat) {
+        if (i < n && (tok[i] == 'f' || tok[i] == 'F' || tok[i] == 'l' || tok[i] == 'L')) i++;
+        return i == n;
+    }
+
+    // Octal when it starts with 0
+    if (!hex && tok[0] == '0') {
+        for (size_t j = 1; j < i; j++) {
+            if (tok[j] > '7') return false;
         }
-        // Handle integers
-        size_t pos;
-        stol(tok, &pos);
-        return pos == tok.length();
     }
-    catch (...) {
-        return false;
+    bool u = false, l = false;
+    while (i < n) {
+        if (!u && (tok[i] == 'u' || tok[i] == 'U')) {
+            u = true;
+            i++;
+        }
+        else if (!l && (tok[i] == 'l' || tok[i] == 'L')) {
+            l = true;
+            i += i + 1 < n && tok[i + 1] == tok[i] ? 2 : 1;
+        }
+        else {
+            return false;
+        }
     }
+    return true;
 }
 
-bool isIdentifier(const string& tok) {
+bool isIdentifier(string_view tok) {
     if (tok.empty()) return false;
     if (!isalpha(tok[0]) && tok[0] != '_') return false;
     for (char c : tok) {
@@ -76,111 +250,344 @@ bool isIdentifier(const string& tok) {
     return true;
 }
 
-vector<string> tokenize(const string& line) {
-    vector<string> toks;
-    string currTok;
-    bool inStr = false, inChr = false;
-
-    for (size_t i = 0; i < line.length(); i++) {
-        char c = line[i];
-        char nextC = (i < line.length() - 1) ? line[i + 1] : ' ';
-
-        if (c == '\"' && !inChr) {
-            inStr = !inStr;
-            currTok += c;
-            if (!inStr) {
-                toks.push_back(currTok);
-                currTok.clear();
-            }
-            continue;
-        }
+TokenKind classify(string_view tok) {
+    switch (charClass.of[(unsigned char)tok[0]]) {
+    case C_IDENT:
+        if (keywords.contains(tok)) return KEYWORD;
+        return isIdentifier(tok) ? IDENTIFIER : INVALID;
+    case C_DIGIT:
+    case C_DOT:
+        return isNum(tok) ? NUMBER : INVALID;
+    case C_QUOTE:
+        return isChar(tok) ? CHAR_CONST : INVALID;
+    case C_DQUOTE:
+        return isStr(tok) ? STRING_CONST : INVALID;
+    case C_OP:
+        return ops.contains(tok) ? OPERATOR : INVALID;
+    case C_PUNCT:
+        return puncs.contains(tok) ? PUNCTUATION : INVALID;
+    default:
+        return INVALID;
+    }
+}
 
-        if (c == '\'' && !inStr) {
-            inChr = !inChr;
-            currTok += c;
-            if (!inChr) {
-                toks.push_back(currTok);
-                currTok.clear();
-            }
-            continue;
-        }
+// Function to tell whether tok is the start of a number whose exponent sign
+// comes next: it begins with a digit or '.', and ends in e/E, or in p/P
+// after a 0x prefix
+bool signedExponent(string_view tok) {
+    CharClass first = charClass.of[(unsigned char)tok[0]];
+    if (first != C_DIGIT && first != C_DOT) return false;
+    bool hex = tok.size() > 2 && tok[0] == '0' && (tok[1] == 'x' || tok[1] == 'X');
+    char last = tok.back();
+    return hex ? last == 'p' || last == 'P' : last == 'e' || last == 'E';
+}
 
-        if (inStr || inChr) {
-            currTok += c;
-            continue;
+// Function to lex src[begin, end) in one pass, starting in the given state
+// on line line_no, and append its tokens and comments to toks. A token being
+// built is always a run of adjacent bytes, so only its start is kept. Returns
+// the state at end; line_no is advanced past every newline read.
+LexState lex(string_view src, size_t begin, size_t end, LexState state, int& line_no,
+             vector<Token>& toks) {
+    const size_t NONE = string_view::npos;
+    size_t start = state == CODE ? NONE : begin;
+    int startLine = line_no;
+
+    auto emit = [&](size_t from, size_t to, TokenKind kind) {
+        toks.push_back({from, (uint32_t)(to - from), (uint32_t)startLine, kind});
+    };
+    auto open = [&](size_t at) {
+        if (start == NONE) {
+            start = at;
+            startLine = line_no;
         }
-
-        // Check for two-character operators
-        string maybeOp = string(1, c) + string(1, nextC);
-        if (ops.find(maybeOp) != ops.end()) {
-            if (!currTok.empty()) {
-                toks.push_back(currTok);
-                currTok.clear();
+    };
+    auto flush = [&](size_t to) {
+        if (start != NONE) {
+            emit(start, to, classify(src.substr(start, to - start)));
+            start = NONE;
+        }
+    };
+
+    for (size_t i = begin; i < end; i++) {
+        char c = src[i];
+        char nextC = i + 1 < end ? src[i + 1] : ' ';
+
+        switch (state) {
+        case CODE: {
+            CharClass cc = charClass.of[(unsigned char)c];
+            if (c == '/' && (nextC == '/' || nextC == '*')) {
+                flush(i);
+                open(i);
+                state = nextC == '/' ? LINE_COMMENT : BLOCK_COMMENT;
+                i++;
+            }
+            else if (cc == C_QUOTE || cc == C_DQUOTE) {
+                // A literal joins whatever word it follows, as before
+                open(i);
+                state = cc == C_DQUOTE ? IN_STRING : IN_CHAR;
+            }
+            else if ((c == '+' || c == '-') && start != NONE && signedExponent(src.substr(start, i - start))) {
+                // The sign of 1e-5 or 0x1p+3 belongs to the number
+            }
+            else if (cc == C_OP) {
+                flush(i);
+                startLine = line_no;
+                // Check for two-character operators
+                if (i + 1 < end && ops.contains(src.substr(i, 2))) {
+                    emit(i, i + 2, OPERATOR);
+                    i++; // Skip next character
+                }
+                else {
+                    emit(i, i + 1, OPERATOR);
+                }
             }
-            toks.push_back(maybeOp);
-            i++; // Skip next character
-            continue;
+            else if (cc == C_SPACE) {
+                flush(i);
+                if (c == '\n') line_no++;
+            }
+            else if (cc == C_PUNCT) {
+                flush(i);
+                startLine = line_no;
+                emit(i, i + 1, PUNCTUATION);
+            }
+            else {
+                open(i);
+            }
+            break;
         }
 
-        if (isspace(c)) {
-            if (!currTok.empty()) {
-                toks.push_back(currTok);
-                currTok.clear();
+        case IN_STRING:
+        case IN_CHAR:
+            if (c == '\\' && i + 1 < end) {
+                // An escaped newline continues the literal on the next line
+                if (nextC == '\n') line_no++;
+                i++;
             }
-        }
-        else if (ops.find(string(1, c)) != ops.end() || puncs.find(string(1, c)) != puncs.end()) {
-            if (!currTok.empty()) {
-                toks.push_back(currTok);
-                currTok.clear();
+            else if (c == (state == IN_STRING ? '\"' : '\'')) {
+                flush(i + 1);
+                state = CODE;
             }
-            toks.push_back(string(1, c));
-        }
-        else {
-            currTok += c;
+            else if (c == '\n') {
+                // Unterminated: the literal ends with its line
+                flush(i);
+                line_no++;
+                state = CODE;
+            }
+            break;
+
+        case LINE_COMMENT:
+            if (c == '\n') {
+                size_t to = i;
+                while (src[to - 1] == ' ' || src[to - 1] == '\t') to--;
+                emit(start, to, COMMENT);
+                start = NONE;
+                line_no++;
+                state = CODE;
+            }
+            break;
+
+        case BLOCK_COMMENT:
+            if (c == '\n') {
+                line_no++;
+            }
+            else if (c == '*' && nextC == '/') {
+                emit(start, i + 2, COMMENT);
+                start = NONE;
+                i++;
+                state = CODE;
+            }
+            break;
         }
     }
 
-    if (!currTok.empty()) {
-        toks.push_back(currTok);
+    if (start != NONE) {
+        if (state == LINE_COMMENT || state == BLOCK_COMMENT) emit(start, end, COMMENT);
+        else flush(end);
     }
+    return state;
+}
 
-    return toks;
+// Function to run job(0) .. job(jobs - 1) on a pool of threads, each taking
+// the next unclaimed index until none are left
+template <typename Job>
+void runPool(size_t jobs, int threads, Job job) {
+    atomic<size_t> next(0);
+    auto work = [&]() {
+        for (size_t j; (j = next++) < jobs;) job(j);
+    };
+    if (threads <= 1 || jobs <= 1) {
+        work();
+        return;
+    }
+    vector<thread> pool;
+    for (int t = 0; t < threads && t < (int)jobs; t++) pool.emplace_back(work);
+    for (thread& th : pool) th.join();
 }
 
-void processLine(const string& line, int line_no) {
-    vector<string> tokens = tokenize(line);
+void lexChunk(string_view src, LexChunk& ch) {
+    ch.toks.clear();
+    int line_no = 1;
+    ch.exit = lex(src, ch.begin, ch.end, ch.entry, line_no, ch.toks);
+    ch.lines = line_no - 1;
+}
 
-    for (const string& tok : tokens) {
-        if (tok.empty()) continue;
+// Function to move one chunk's token lines from chunk-relative to file lines
+// and record its identifiers (last line seen) and invalid tokens
+void collect(string_view src, LexChunk& ch, int firstLine) {
+    ch.symbols.clear();
+    ch.errors.clear();
+    for (size_t i = 0; i < ch.toks.size(); i++) {
+        Token& t = ch.toks[i];
+        t.line += firstLine - 1;
+        if (i < ch.skip) continue;
+        string_view tok = src.substr(t.offset, t.length);
+        if (t.kind == IDENTIFIER) ch.symbols[tok] = t.line;
+        else if (t.kind == INVALID) ch.errors[t.line].push_back("Invalid token: " + string(tok));
+    }
+}
 
-        if (keywords.find(tok) != keywords.end()) {
-            cout << "Keyword: " << tok << endl;
-        }
-        else if (ops.find(tok) != ops.end()) {
-            cout << "Operator: " << tok << endl;
-        }
-        else if (puncs.find(tok) != puncs.end()) {
-            cout << "Punctuation: " << tok << endl;
-        }
-        else if (isNum(tok)) {
-            cout << "Number: " << tok << endl;
+// Function to lex src on up to threads threads. Chunks are lexed at once on
+// the guess that each starts in code, which holds unless the previous chunk
+// ends inside a block comment or a literal continued by a backslash-newline;
+// those chunks are lexed again, in order, from the state they really start
+// in. Tokens cut by a chunk boundary are then joined, so the result equals
+// lexing the whole file as one chunk.
+vector<LexChunk> lexSource(string_view src, int threads) {
+    const size_t MIN_CHUNK = 1 << 18;
+    size_t count = threads > 1 ? min((size_t)threads * 4, src.size() / MIN_CHUNK) : 1;
+    if (count == 0) count = 1;
+
+    vector<LexChunk> chunks;
+    for (size_t begin = 0, k = 1; begin < src.size() || chunks.empty(); k++) {
+        size_t end = k < count ? src.find('\n', max(begin, src.size() / count * k)) : string_view::npos;
+        end = end == string_view::npos ? src.size() : end + 1;
+        chunks.emplace_back();
+        chunks.back().begin = begin;
+        chunks.back().end = end;
+        begin = end;
+    }
+
+    runPool(chunks.size(), threads, [&](size_t k) { lexChunk(src, chunks[k]); });
+
+    vector<int> firstLine(chunks.size(), 1);
+    Token* last = NULL;
+    for (size_t k = 0; k < chunks.size(); k++) {
+        LexChunk& ch = chunks[k];
+        if (k > 0) {
+            firstLine[k] = firstLine[k - 1] + chunks[k - 1].lines;
+            if (ch.entry != chunks[k - 1].exit) {
+                ch.entry = chunks[k - 1].exit;
+                lexChunk(src, ch);
+            }
         }
-        else if (isChar(tok)) {
-            cout << "Character Constant: " << tok << endl;
+        if (ch.entry != CODE && last != NULL) {
+            const Token& rest = ch.toks[0];
+            last->length = rest.offset + rest.length - last->offset;
+            if (rest.kind != COMMENT) last->kind = classify(src.substr(last->offset, last->length));
+            ch.skip = 1;
         }
-        else if (isStr(tok)) {
-            cout << "String Constant: " << tok << endl;
+        if (ch.toks.size() > ch.skip) last = &ch.toks.back();
+    }
+
+    runPool(chunks.size(), threads, [&](size_t k) { collect(src, chunks[k], firstLine[k]); });
+    return chunks;
+}
+
+// Function to print tokens in source order and merge the chunks' identifiers
+// and invalid tokens into the symbol table and error list
+void report(string_view src, const vector<LexChunk>& chunks) {
+    for (const LexChunk& ch : chunks) {
+        for (size_t i = ch.skip; i < ch.toks.size(); i++) {
+            const Token& t = ch.toks[i];
+            string_view tok = src.substr(t.offset, t.length);
+
+            switch (t.kind) {
+            case KEYWORD:
+                cout << "Keyword: " << tok << '\n';
+                break;
+            case OPERATOR:
+                cout << "Operator: " << tok << '\n';
+                break;
+            case PUNCTUATION:
+                cout << "Punctuation: " << tok << '\n';
+                break;
+            case NUMBER:
+                cout << "Number: " << tok << '\n';
+                break;
+            case CHAR_CONST:
+                cout << "Character Constant: " << tok << '\n';
+                break;
+            case STRING_CONST:
+                cout << "String Constant: " << tok << '\n';
+                break;
+            case IDENTIFIER:
+                cout << "Identifier: " << tok << '\n';
+                break;
+            case COMMENT:
+                cout << "Comment at line " << t.line << ": " << tok << '\n';
+                break;
+            case INVALID:
+                break;
+            }
         }
-        else if (isIdentifier(tok)) {
-            cout << "Identifier: " << tok << endl;
-            symTable[tok] = line_no;
+
+        for (const auto& entry : ch.symbols) {
+            auto it = symTable.find(entry.first);
+            if (it == symTable.end()) symTable.emplace(entry.first, entry.second);
+            else it->second = entry.second;
         }
-        else {
-            addErr(line_no, "Invalid token: " + tok);
+        for (const auto& entry : ch.errors) {
+            vector<string>& errs = errList[entry.first];
+            errs.insert(errs.end(), entry.second.begin(), entry.second.end());
         }
     }
 }
 
+// Function to time the per-token classification chain (keyword, operator,
+// punctuation) with the perfect hashes against the std::set lookups they
+// replaced, on a mix of keywords, operators, punctuation and identifiers
+void benchmarkClassify() {
+    set<string> oldKeywords(begin(KEYWORDS), end(KEYWORDS));
+    set<string> oldOps(begin(OPS), end(OPS));
+    set<string> oldPuncs(begin(PUNCS), end(PUNCS));
+
+    vector<string> sample;
+    for (string_view w : KEYWORDS) sample.emplace_back(w);
+    for (string_view w : OPS) sample.emplace_back(w);
+    for (string_view w : PUNCS) sample.emplace_back(w);
+    const char* idents[] = {"i", "count", "value12", "buffer_size", "x", "main", "printf",
+                            "tmp", "node", "next", "len", "result", "p", "q", "index"};
+    for (int r = 0; r < 3; r++) {
+        for (const char* id : idents) sample.emplace_back(id);
+    }
+    const size_t ROUNDS = 200000;
+
+    auto time = [&](const char* name, auto classify) {
+        size_t sum = 0;
+        auto start = chrono::steady_clock::now();
+        for (size_t r = 0; r < ROUNDS; r++) {
+            for (const string& tok : sample) sum += classify(tok);
+        }
+        chrono::duration<double> secs = chrono::steady_clock::now() - start;
+        cout << name << secs.count() * 1e9 / (ROUNDS * sample.size()) << " ns/token (checksum "
+             << sum << ")" << endl;
+    };
+
+    cout << "Tokens      : " << sample.size() << " x " << ROUNDS << endl;
+    time("std::set    : ", [&](const string& tok) {
+        if (oldKeywords.find(tok) != oldKeywords.end()) return 1;
+        if (oldOps.find(tok) != oldOps.end()) return 2;
+        if (oldPuncs.find(tok) != oldPuncs.end()) return 3;
+        return 0;
+    });
+    time("Perfect hash: ", [&](const string& tok) {
+        if (keywords.contains(tok)) return 1;
+        if (ops.contains(tok)) return 2;
+        if (puncs.contains(tok)) return 3;
+        return 0;
+    });
+}
+
 void printSymbolTable() {
     cout << "\nSymbol Table:" << endl;
     cout << "=========================" << endl;
@@ -208,85 +615,111 @@ void printErrors() {
     }
 }
 
-int main() {
-    ifstream file("test.c");
-    if (!file.is_open()) {
-        cout << "File not Found!" << endl;
-        return 1;
-    }
-
-    cout << " test.c" << endl;
-    int line_no = 1;
-    bool inComment = false;
-    string line;
+// Function to map a whole file read-only. size is 0 when the file cannot be
+// opened; base is NULL when it is empty or cannot be mapped.
+bool mapFile(const char* path, void*& base, size_t& size) {
+    base = NULL;
+    size = 0;
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) return false;
+    LARGE_INTEGER fileSize;
+    GetFileSizeEx(file, &fileSize);
+    size = fileSize.QuadPart;
+    HANDLE mapping = size ? CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL) : NULL;
+    base = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+    if (mapping) CloseHandle(mapping);
+    CloseHandle(file);
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    fstat(fd, &st);
+    size = st.st_size;
+    base = size ? mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0) : NULL;
+    if (base == MAP_FAILED) base = NULL;
+    close(fd);
+#endif
+    return base != NULL || size == 0;
+}
 
-    while (getline(file, line)) {
-        // Remove leading and trailing whitespace
-        line.erase(0, line.find_first_not_of(" \t"));
-        line.erase(line.find_last_not_of(" \t") + 1);
+void unmapFile(void* base, size_t size) {
+    if (base == NULL) return;
+#ifdef _WIN32
+    UnmapViewOfFile(base);
+#else
+    munmap(base, size);
+#endif
+}
 
-        if (line.empty()) {
-            line_no++;
-            continue;
-        }
+// Function to time lexing alone (no printing) over a mapped file, serially
+// and on the given number of threads, and check both give the same tokens
+void benchmarkLex(string_view src, int threads) {
+    vector<vector<LexChunk>> results;
+    for (int t : {1, threads}) {
+        auto start = chrono::steady_clock::now();
+        results.push_back(lexSource(src, t));
+        chrono::duration<double> secs = chrono::steady_clock::now() - start;
+        size_t tokens = 0;
+        for (const LexChunk& ch : results.back()) tokens += ch.toks.size() - ch.skip;
+        cout << setw(3) << t << " thread(s): " << results.back().size() << " chunk(s), "
+             << tokens << " tokens, " << secs.count() * 1e3 << " ms ("
+             << src.size() / 1e6 / secs.count() << " MB/s)" << endl;
+    }
 
-        if (inComment) {
-            size_t endComment = line.find("*/");
-            if (endComment != string::npos) {
-                string afterComment = line.substr(endComment + 2);
-                afterComment.erase(0, afterComment.find_first_not_of(" \t"));
-                
-                if (!afterComment.empty()) {
-                    processLine(afterComment, line_no);
-                }
-                inComment = false;
-            }
-            line_no++;
-            continue;
-        }
+    auto flatten = [](const vector<LexChunk>& chunks) {
+        vector<Token> all;
+        for (const LexChunk& ch : chunks) all.insert(all.end(), ch.toks.begin() + ch.skip, ch.toks.end());
+        return all;
+    };
+    vector<Token> a = flatten(results[0]), b = flatten(results[1]);
+    bool same = a.size() == b.size();
+    for (size_t i = 0; same && i < a.size(); i++) {
+        same = a[i].offset == b[i].offset && a[i].length == b[i].length
+            && a[i].line == b[i].line && a[i].kind == b[i].kind;
+    }
+    cout << "Input : " << src.size() / 1e6 << " MB" << endl;
+    cout << "Tokens match serial: " << (same ? "yes" : "NO") << endl;
+}
 
-        if (line.substr(0, 2) == "//") {
-            cout << "Comment at line " << line_no << ": " << line << endl;
-            line_no++;
-            continue;
+int main(int argc, char* argv[]) {
+    bool bench = false;
+    int threads = thread::hardware_concurrency();
+    const char* path = "test.c";
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--bench-classify") {
+            benchmarkClassify();
+            return 0;
         }
+        if (arg == "--bench-lex") bench = true;
+        else if (arg == "--threads" && i + 1 < argc) threads = atoi(argv[++i]);
+        else path = argv[i];
+    }
+    if (threads <= 0) threads = 1;
 
-        size_t commentStart = line.find("/*");
-        if (commentStart != string::npos) {
-            string beforeComment = line.substr(0, commentStart);
-            beforeComment.erase(0, beforeComment.find_first_not_of(" \t"));
-            
-            if (!beforeComment.empty()) {
-                processLine(beforeComment, line_no);
-            }
-
-            cout << "Comment at line " << line_no << ": ";
-            size_t commentEnd = line.find("*/", commentStart);
-            if (commentEnd != string::npos) {
-                cout << line.substr(commentStart, commentEnd - commentStart + 2) << endl;
-                
-                string afterComment = line.substr(commentEnd + 2);
-                afterComment.erase(0, afterComment.find_first_not_of(" \t"));
-                
-                if (!afterComment.empty()) {
-                    processLine(afterComment, line_no);
-                }
-            }
-            else {
-                cout << line.substr(commentStart) << endl;
-                inComment = true;
-            }
-            line_no++;
-            continue;
-        }
+    void* base;
+    size_t size;
+    if (!mapFile(path, base, size)) {
+        cout << (size == 0 ? "File not Found!" : "Cannot map file!") << endl;
+        return 1;
+    }
+    string_view src((const char*)base, size);
 
-        processLine(line, line_no);
-        line_no++;
+    if (bench) {
+        benchmarkLex(src, threads);
+        unmapFile(base, size);
+        return 0;
     }
 
+    ios::sync_with_stdio(false);
+    cout << " " << path << endl;
+    report(src, lexSource(src, threads));
+
     printSymbolTable();
     printErrors();
-    
-    file.close();
+
+    unmapFile(base, size);
     return 0;
-}
\ No newline at end of file
+}